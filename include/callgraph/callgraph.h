@@ -3,10 +3,16 @@
 // High-level abstract interface for call-graph
 //
 // Random call graph consists (obviously) from vertices and edges
-// vertex properties: funcid, componentno, depth, nparms
+// vertex properties: funcid, componentno, moduleno, depth, nparms
 // edge properties: calltype
 //
 // From users' perspective each function have its callee and caller sets
+// After construction these sets are frozen into flat arrays partitioned by
+// calltype, so masked size and random access queries are O(1)
+// Also reachability index over direct and conditional calls is built once:
+// SCCs numbered in topological order and per-SCC transitive callee bitsets,
+// so "may f reach g" and "is f recursive" queries are O(1). Indirect calls
+// are ranked on top of it, so "may f call g indirectly" is O(1) too
 //
 //------------------------------------------------------------------------------
 //
@@ -21,8 +27,11 @@
 #include "calltypes.h"
 #include "config/configs.h"
 #include "funcmeta.h"
+#include "utils/string_arena.h"
 
+#include <cstdint>
 #include <memory>
+#include <string_view>
 
 #include <boost/graph/adjacency_list.hpp>
 #include <boost/graph/graph_traits.hpp>
@@ -44,6 +53,45 @@ private:
   std::set<vertex_t> leafs_;
   std::vector<std::vector<vertex_t>> comps_;
   std::vector<vertex_t> inds_;
+  int nindirect_ = 0;
+
+  // frozen adjacency: callees of v having k-th calltype are
+  // callees_[callee_offs_[v * NCALLTYPES + k] .. callee_offs_[... + 1])
+  // same for callers
+  std::vector<int> callee_offs_;
+  std::vector<vertex_t> callees_;
+  std::vector<int> caller_offs_;
+  std::vector<vertex_t> callers_;
+
+  // reachability index: SCC of every function, SCCs are numbered in
+  // topological order of condensation (callers before callees)
+  // SCCs reachable from c (all greater than c) are bits of window
+  // reach_bits_[reach_offs_[c] .. reach_offs_[c + 1]), starting from
+  // word reach_lo_[c], i.e. from SCC number 64 * reach_lo_[c]
+  std::vector<int> scc_;
+  std::vector<char> recursive_;
+  std::vector<int> reach_lo_;
+  std::vector<int> reach_offs_;
+  std::vector<std::uint64_t> reach_bits_;
+
+  // indirect calls: rank of function in indirect set (-1 if not there)
+  // and greatest rank of indirect set member reaching SCC or in it
+  // (-1 if none), see may_call_indirect
+  std::vector<int> indrank_;
+  std::vector<int> indreach_;
+
+  // type acceptance for every metastructure class (see ms::meta_class):
+  // bit t of accept_bits_[c * accept_words_ ...] is set if class c accepts
+  // type t, accepted_[c] lists accepted types in increasing order
+  int accept_words_ = 0;
+  std::vector<std::uint64_t> accept_bits_;
+  std::vector<std::vector<int>> accepted_;
+
+  // interned function names and signatures, see intern_names
+  utils::string_arena_t names_;
+
+  // functions of every module, ordered by funcid
+  std::vector<std::vector<vertex_t>> modules_;
 
   // public interface
 public:
@@ -54,33 +102,86 @@ public:
 
   int nfuncs() const { return boost::num_vertices(graph_); }
 
+  // every function is reachable from main
+  vertex_t main_func() const { return comps_[0][0]; }
+
   callee_iterator_t callees_begin(vertex_t v, calltype_t mask) const;
   callee_iterator_t callees_end(vertex_t v, calltype_t mask) const;
   caller_iterator_t callers_begin(vertex_t v, calltype_t mask) const;
   caller_iterator_t callers_end(vertex_t v, calltype_t mask) const;
 
+  int ncallees(vertex_t v, calltype_t mask) const {
+    return callees_end(v, mask) - callees_begin(v, mask);
+  }
+
+  int ncallers(vertex_t v, calltype_t mask) const {
+    return callers_end(v, mask) - callers_begin(v, mask);
+  }
+
   vertexprop_t vertex_from(vertex_t v) const { return graph_[v]; }
-  vertex_t dest_from(edge_t e) const { return boost::target(e, graph_); }
-  vertex_t src_from(edge_t e) const { return boost::source(e, graph_); }
+
+  // f calls g through non-empty chain of direct and conditional calls
+  bool may_reach(vertex_t f, vertex_t g) const;
+
+  // f may call itself, i.e. may_reach(f, f)
+  bool is_recursive(vertex_t f) const { return recursive_[scc_[f]]; }
+
+  int nsccs() const { return recursive_.size(); }
+  int scc_of(vertex_t f) const { return scc_[f]; }
+
+  // f may call g through pointer without closing a cycle, whatever other
+  // indirect calls, which also pass this check, are made
+  bool may_call_indirect(vertex_t f, vertex_t g) const {
+    return indrank_[g] > indreach_[scc_[f]];
+  }
+
+  // function name like foo5 and signature like T3 foo5(A2, S4)
+  std::string_view func_name(vertex_t v) const { return names_[2 * v]; }
+  std::string_view signature(vertex_t v) const { return names_[2 * v + 1]; }
+
+  int nmodules() const { return modules_.size(); }
+
+  module_iterator_t module_begin(int m) const { return modules_[m].begin(); }
+  module_iterator_t module_end(int m) const { return modules_[m].end(); }
 
   void dump(std::ostream &os) const;
 
-  bool accept_type(vertex_t v, tg::vertex_t vt) const;
+  // single bit test in acceptance bitmap of function metastructure class
+  bool accept_type(vertex_t v, tg::vertex_t vt) const {
+    int c = ms::meta_class(graph_[v].metainfo);
+    std::uint64_t w = accept_bits_[c * accept_words_ + vt / 64];
+    return (w >> (vt % 64)) & 1;
+  }
+
+  // all types, accepted by function, n-th is accepted_type(v, n)
+  int naccepted(vertex_t v) const {
+    return accepted_[ms::meta_class(graph_[v].metainfo)].size();
+  }
+
+  int accepted_type(vertex_t v, int n) const {
+    return accepted_[ms::meta_class(graph_[v].metainfo)][n];
+  }
 
   // construction helpers
 private:
   void generate_random_graph(int nvertices);
   void process_leafs();
   void connect_components();
+  void limit_paths();
   void add_self_loops();
   void create_indcalls();
+  void freeze_adjacency();
+  void build_reachability();
+  void rank_indirect();
   void decide_metastructure();
+  void build_accept_tables();
   void assign_types();
   std::pair<int, std::vector<int>> gen_params(vertex_t v);
   bool accept_type(ms::metanode_t m, tg::vertexprop_t vpt) const;
   bool accept_abi_type(vertexprop_t vp, tg::vertexprop_t vpt,
                        bool ret_type) const;
   int pick_typeid(vertex_t v, bool allow_void = false, bool ret_type = false);
+  void intern_names();
   void map_modules();
 };
 
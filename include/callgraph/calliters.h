@@ -2,6 +2,11 @@
 //
 //  Function iterators support
 //
+//  Frozen callgraph keeps neighbours of every function in flat array,
+//  partitioned by calltype: [ DIRECT | CONDITIONAL | INDIRECT ]
+//  Any mask then selects at most two spans of this array (only DIRECT |
+//  INDIRECT is not contiguous), so iterator is random access
+//
 //------------------------------------------------------------------------------
 //
 // This file is licensed after LGPL v3
@@ -11,54 +16,37 @@
 
 #pragma once
 
+#include <iterator>
 #include <utility>
-
-#include <boost/graph/adjacency_list.hpp>
-#include <boost/graph/graph_traits.hpp>
+#include <vector>
 
 #include "calltypes.h"
 
 namespace cg {
 
-class callgraph_t;
-
-vertexprop_t vertex_from(const callgraph_t *, vertex_t);
-vertex_t dest_from(const callgraph_t *, edge_t);
-vertex_t src_from(const callgraph_t *, edge_t);
-
 // neighbour iterator traversing neighbours (childs/parents) of given vertex
-template <typename eit> class nbr_iterator_t {
-  const callgraph_t *cgp_;
-  eit ei_;
-  calltype_t mask_;
+// logically it walks over [base, base + first) ++ [base + first + gap, ...)
+class nbr_iterator_t {
+  const vertex_t *base_ = nullptr;
+  int first_ = 0;
+  int gap_ = 0;
+  int idx_ = 0;
 
 public:
-  nbr_iterator_t(const callgraph_t *cgp, eit ei, calltype_t mask)
-      : cgp_(cgp), ei_(ei), mask_(mask) {
-    // TODO: we shall here skip from eit all that is not conform to mask
-    // say function have outedges: c c i c d d c i
-    // then on indirect mask we shall skip first 2 cs
-  }
-
-  nbr_iterator_t(const nbr_iterator_t &) = default;
-  nbr_iterator_t &operator=(const nbr_iterator_t &) = default;
-
-  nbr_iterator_t(nbr_iterator_t &&) = default;
-  nbr_iterator_t &operator=(nbr_iterator_t &&) = default;
+  nbr_iterator_t() = default;
+  nbr_iterator_t(const vertex_t *base, int first, int gap, int idx)
+      : base_(base), first_(first), gap_(gap), idx_(idx) {}
 
   using iterator_type = nbr_iterator_t;
-
-  // never random access because it may skip some functions under the mask
-  using iterator_category = std::bidirectional_iterator_tag;
+  using iterator_category = std::random_access_iterator_tag;
 
   using value_type = vertex_t;
   using difference_type = int;
-  using pointer = value_type *;
-  using reference = value_type &;
+  using pointer = const value_type *;
+  using reference = const value_type &;
 
   nbr_iterator_t &operator++() {
-    // TODO: skip along the way
-    ++ei_;
+    ++idx_;
     return *this;
   }
 
@@ -69,14 +57,12 @@ public:
   }
 
   nbr_iterator_t &operator+=(int n) {
-    for (int i = 0; i < n; ++i)
-      ++(*this);
+    idx_ += n;
     return *this;
   }
 
   nbr_iterator_t &operator--() {
-    // TODO: skip along the way
-    --ei_;
+    --idx_;
     return *this;
   }
 
@@ -87,65 +73,72 @@ public:
   }
 
   nbr_iterator_t &operator-=(int n) {
-    for (int i = 0; i < n; ++i)
-      --(*this);
+    idx_ -= n;
     return *this;
   }
 
-  value_type operator*() const;
+  reference operator*() const {
+    return base_[idx_ < first_ ? idx_ : idx_ + gap_];
+  }
+
+  pointer operator->() const { return &**this; }
+
+  reference operator[](int n) const { return *(*this + n); }
 
   bool equals(const nbr_iterator_t &lhs) const {
-    return (lhs.cgp_ == cgp_) && (lhs.ei_ == ei_);
+    return (lhs.base_ == base_) && (lhs.idx_ == idx_);
   }
 
-  eit base() { return ei_; }
-};
+  int index() const { return idx_; }
+
+  friend nbr_iterator_t operator+(nbr_iterator_t it, int n) {
+    it += n;
+    return it;
+  }
 
-template <>
-nbr_iterator_t<outedge_iter_t>::value_type
-nbr_iterator_t<outedge_iter_t>::operator*() const;
+  friend nbr_iterator_t operator+(int n, nbr_iterator_t it) {
+    it += n;
+    return it;
+  }
 
-template <>
-nbr_iterator_t<inedge_iter_t>::value_type
-nbr_iterator_t<inedge_iter_t>::operator*() const;
+  friend nbr_iterator_t operator-(nbr_iterator_t it, int n) {
+    it -= n;
+    return it;
+  }
+};
 
-using callee_iterator_t = nbr_iterator_t<outedge_iter_t>;
-using caller_iterator_t = nbr_iterator_t<inedge_iter_t>;
+using callee_iterator_t = nbr_iterator_t;
+using caller_iterator_t = nbr_iterator_t;
 
-static inline bool operator==(callee_iterator_t lhs, callee_iterator_t rhs) {
+// iterator over functions of given module
+using module_iterator_t = std::vector<vertex_t>::const_iterator;
+
+static inline bool operator==(nbr_iterator_t lhs, nbr_iterator_t rhs) {
   return lhs.equals(rhs);
 }
 
-static inline bool operator!=(callee_iterator_t lhs, callee_iterator_t rhs) {
+static inline bool operator!=(nbr_iterator_t lhs, nbr_iterator_t rhs) {
   return !lhs.equals(rhs);
 }
 
-static inline callee_iterator_t operator+(callee_iterator_t it, int n) {
-  it += n;
-  return it;
+static inline int operator-(nbr_iterator_t lhs, nbr_iterator_t rhs) {
+  return lhs.index() - rhs.index();
 }
 
-static inline callee_iterator_t operator-(callee_iterator_t it, int n) {
-  it -= n;
-  return it;
+static inline bool operator<(nbr_iterator_t lhs, nbr_iterator_t rhs) {
+  return lhs.index() < rhs.index();
 }
 
-static inline bool operator==(caller_iterator_t lhs, caller_iterator_t rhs) {
-  return lhs.equals(rhs);
-}
-
-static inline bool operator!=(caller_iterator_t lhs, caller_iterator_t rhs) {
-  return !lhs.equals(rhs);
+static inline bool operator>(nbr_iterator_t lhs, nbr_iterator_t rhs) {
+  return rhs < lhs;
 }
 
-static inline caller_iterator_t operator+(caller_iterator_t it, int n) {
-  it += n;
-  return it;
+static inline bool operator<=(nbr_iterator_t lhs, nbr_iterator_t rhs) {
+  return !(rhs < lhs);
 }
 
-static inline caller_iterator_t operator-(caller_iterator_t it, int n) {
-  it -= n;
-  return it;
+static inline bool operator>=(nbr_iterator_t lhs, nbr_iterator_t rhs) {
+  return !(lhs < rhs);
 }
 
-} // namespace cg
\ No newline at end of file
+} // namespace cg
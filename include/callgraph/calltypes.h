@@ -4,8 +4,9 @@
 //
 //  This file defines all function types and graph type for callgraph
 //
-//  We have no distinguished INDIRECT call type because call graph have no
-//  indirect edges
+//  Call graph have no indirect edges: INDIRECT call type is only a mask bit
+//  selecting indirect set members (any function may call them through
+//  pointer) in callee and caller queries
 //
 //------------------------------------------------------------------------------
 //
@@ -28,16 +29,30 @@ class typegraph_t;
 
 namespace cg {
 
-enum class calltype_t : unsigned char { DIRECT = 1, CONDITIONAL = 2 };
+// calltypes are bits, so masks like DIRECT | CONDITIONAL are possible
+enum class calltype_t : unsigned char {
+  DIRECT = 1,
+  CONDITIONAL = 2,
+  INDIRECT = 4,
+  ALL = 7
+};
+
+// number of separate calltypes (bits) above
+constexpr int NCALLTYPES = 3;
+
+constexpr calltype_t operator|(calltype_t lhs, calltype_t rhs) {
+  return static_cast<calltype_t>(static_cast<unsigned>(lhs) |
+                                 static_cast<unsigned>(rhs));
+}
 
 struct vertexprop_t {
   int funcid = -1;
   int componentno = -1;
+  int moduleno = -1;
   int indset = 0;
   int rettype = -1;
   ms::metanode_t metainfo;
   std::vector<int> argtypes;
-  std::string get_name(std::shared_ptr<tg::typegraph_t>) const;
   std::string get_color() const;
 };
 
@@ -23,6 +23,14 @@ struct metanode_t {
   unsigned usepointers : 1;
 };
 
+// metanodes are 4 bits, so there are only 16 distinct classes
+constexpr int NMETACLASSES = 16;
+
+inline int meta_class(metanode_t m) {
+  return m.usesigned | (m.usefloat << 1) | (m.usecomplex << 2) |
+         (m.usepointers << 3);
+}
+
 // create random metainfo node
 metanode_t random_meta(const cfg::config &config);
 
@@ -41,8 +41,10 @@ struct li_task_req_state_t : cn_task_req_state_t {
 };
 
 struct ei_task_req_state_t : li_task_req_state_t {
-  // TODO
-  ei_task_req_state_t(li_task_req_state_t p) : li_task_req_state_t{p} {}
+  locir_sp_t li;
+  int nl;
+  ei_task_req_state_t(li_task_req_state_t p, locir_sp_t l, int n)
+      : li_task_req_state_t{p}, li{l}, nl{n} {}
 };
 
 class coerunner_t {
@@ -50,6 +52,8 @@ class coerunner_t {
   std::vector<std::thread> consumers_;
   int nvar_;
   int nsplits_;
+  int nlocs_;
+  int narith_;
 
 public:
   coerunner_t() {}
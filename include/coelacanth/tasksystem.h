@@ -11,13 +11,16 @@
 
 #pragma once
 
+#include <chrono>
 #include <fstream>
 #include <future>
 #include <mutex>
 #include <queue>
 #include <sstream>
+#include <string>
 #include <thread>
 #include <utility>
+#include <vector>
 
 #include "config/configs.h"
 #include "fireonce.h"
@@ -37,6 +40,10 @@ void push_sentinel_task();
 // push task to global queue
 void push_task(task_t);
 
+// take one task from global queue and run it on calling thread
+// returns false if there was nothing to run
+bool run_pending_task();
+
 // callgraph
 namespace tg {
 class typegraph_t;
@@ -71,19 +78,31 @@ void callgraph_dump(std::shared_ptr<cg::callgraph_t> cg, std::ostream &os);
 
 // varassign
 namespace va {
+class globals_t;
 class varassign_t;
 }
 
+using vg_task_type = std::shared_ptr<const va::globals_t>(
+    int, const cfg::config &, std::shared_ptr<tg::typegraph_t>);
+using globals_future_t =
+    decltype(std::packaged_task<vg_task_type>{}.get_future());
+using globals_sp_t = decltype(globals_future_t{}.get());
+
+std::shared_ptr<const va::globals_t>
+globals_create(int, const cfg::config &, std::shared_ptr<tg::typegraph_t>);
+
 using va_task_type = std::shared_ptr<va::varassign_t>(
     int, const cfg::config &, std::shared_ptr<tg::typegraph_t>,
-    std::shared_ptr<cg::callgraph_t>);
+    std::shared_ptr<cg::callgraph_t>, std::shared_ptr<const va::globals_t>);
 using varassign_future_t =
     decltype(std::packaged_task<va_task_type>{}.get_future());
 using varassign_sp_t = decltype(varassign_future_t{}.get());
 
+// globals layer may be nullptr (every varassign creates own globals)
 std::shared_ptr<va::varassign_t>
 varassign_create(int, const cfg::config &, std::shared_ptr<tg::typegraph_t>,
-                 std::shared_ptr<cg::callgraph_t>);
+                 std::shared_ptr<cg::callgraph_t>,
+                 std::shared_ptr<const va::globals_t>);
 void varassign_dump(std::shared_ptr<va::varassign_t>, std::ostream &);
 
 // controlgraph
@@ -106,10 +125,56 @@ controlgraph_create(int, const cfg::config &, std::shared_ptr<tg::typegraph_t>,
 void controlgraph_dump(std::shared_ptr<cn::controlgraph_t>, std::ostream &os);
 
 // locIR
+namespace li {
+class locir_t;
+}
+
+using li_task_type = std::shared_ptr<li::locir_t>(
+    int, const cfg::config &, std::shared_ptr<tg::typegraph_t>,
+    std::shared_ptr<va::varassign_t>, std::shared_ptr<cn::controlgraph_t>);
+using locir_future_t =
+    decltype(std::packaged_task<li_task_type>{}.get_future());
+using locir_sp_t = decltype(locir_future_t{}.get());
+
+std::shared_ptr<li::locir_t> locir_create(int, const cfg::config &,
+                                          std::shared_ptr<tg::typegraph_t>,
+                                          std::shared_ptr<va::varassign_t>,
+                                          std::shared_ptr<cn::controlgraph_t>);
+
+void locir_dump(std::shared_ptr<li::locir_t>, std::ostream &os);
 
 // exprIR
+namespace ei {
+class exprir_t;
+}
+
+using ei_task_type = std::shared_ptr<ei::exprir_t>(
+    int, const cfg::config &, std::shared_ptr<tg::typegraph_t>,
+    std::shared_ptr<cg::callgraph_t>, std::shared_ptr<li::locir_t>);
+using exprir_future_t =
+    decltype(std::packaged_task<ei_task_type>{}.get_future());
+using exprir_sp_t = decltype(exprir_future_t{}.get());
+
+std::shared_ptr<ei::exprir_t> exprir_create(int, const cfg::config &,
+                                            std::shared_ptr<tg::typegraph_t>,
+                                            std::shared_ptr<cg::callgraph_t>,
+                                            std::shared_ptr<li::locir_t>);
+
+void exprir_dump(std::shared_ptr<ei::exprir_t>, std::ostream &os);
 
 // langprinter
+using lp_task_type = std::size_t(std::shared_ptr<tg::typegraph_t>,
+                                 std::shared_ptr<cg::callgraph_t>,
+                                 std::shared_ptr<va::varassign_t>,
+                                 std::shared_ptr<ei::exprir_t>, std::string);
+using printer_future_t =
+    decltype(std::packaged_task<lp_task_type>{}.get_future());
+
+// prints program to file fname, returns its size
+std::size_t langprinter_print(std::shared_ptr<tg::typegraph_t>,
+                              std::shared_ptr<cg::callgraph_t>,
+                              std::shared_ptr<va::varassign_t>,
+                              std::shared_ptr<ei::exprir_t>, std::string);
 
 //------------------------------------------------------------------------------
 //
@@ -133,3 +198,33 @@ template <typename F, typename... Args> auto create_task(F f, Args &&...args) {
 
   return std::make_pair(std::move(t), std::move(fut));
 }
+
+// wait for future, running queued tasks meanwhile
+// task may wait for its subtasks this way without starving consumers
+template <typename T> void wait_helping(const std::future<T> &fut) {
+  using namespace std::chrono_literals;
+  while (fut.wait_for(0s) != std::future_status::ready)
+    if (!run_pending_task())
+      std::this_thread::yield();
+}
+
+// run f(0), ..., f(n - 1) as tasks on global queue and wait for all of them
+// first exception thrown by f (if any) is rethrown after all are done
+template <typename F> void parallel_for(int n, F f) {
+  std::vector<std::future<void>> futs;
+  futs.reserve(n);
+  for (int i = 0; i < n; ++i) {
+    std::packaged_task<void()> tsk{[&f, i] { f(i); }};
+    futs.emplace_back(tsk.get_future());
+    push_task(task_t{[ct = std::move(tsk)]() mutable {
+      ct();
+      return 0;
+    }});
+  }
+
+  for (auto &fut : futs)
+    wait_helping(fut);
+
+  for (auto &fut : futs)
+    fut.get();
+}
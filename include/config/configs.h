@@ -20,6 +20,7 @@
 #pragma once
 
 #include <iostream>
+#include <limits>
 #include <map>
 #include <mutex>
 #include <random>
@@ -113,6 +114,7 @@ public:
   int get(int id) const;
   std::string gets(int id) const;
   std::pair<int, int> minmax(int id) const;
+  double pflag_prob(int id) const;
   size_t prob_size(int id) const;
   bool quiet() const { return quiet_; }
   bool dumps() const { return dump_; }
@@ -122,6 +124,12 @@ public:
   int rand_positive() const {
     return rand_from(0, std::numeric_limits<int>::max());
   }
+
+  // restart random sequence (options are same)
+  void reseed(int seed) {
+    std::lock_guard<std::mutex> lk{mt_mutex};
+    mt_source.seed(seed);
+  }
 };
 
 template <typename T> int get(const config &cfg, T id) {
@@ -136,12 +144,28 @@ template <typename T> std::pair<int, int> minmax(const config &cfg, T id) {
   return cfg.minmax(static_cast<int>(id));
 }
 
+// probability for pflag option to be 1
+template <typename T> double pflag_prob(const config &cfg, T id) {
+  return cfg.pflag_prob(static_cast<int>(id));
+}
+
 template <typename T> size_t prob_size(const config &cfg, T id) {
   return cfg.prob_size(static_cast<int>(id));
 }
 
 config read_global_config(int argc, char **argv);
 
+// seed for n-th independent substream of given seed
+// (splitmix64 finalizer, so neighbouring n give unrelated seeds)
+inline int derive_seed(int seed, int n) {
+  unsigned long long z = (static_cast<unsigned long long>(seed) << 32) +
+                         static_cast<unsigned>(n) + 0x9e3779b97f4a7c15ULL;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  z = z ^ (z >> 31);
+  return static_cast<int>(z & std::numeric_limits<int>::max());
+}
+
 void postverify(const config &cf);
 
 //------------------------------------------------------------------------------
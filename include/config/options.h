@@ -41,6 +41,8 @@ enum class PGC {
   STOP_ON_CN,
   USECN,
   CNNAME,
+  STOP_ON_LI,
+  STOP_ON_EI,
   MAX
 };
 
@@ -75,9 +77,10 @@ enum class CG {
   ADDLEAFS,
   SELFLOOP,
   INDSETCNT,
-  ARTIFICIAL_CONNS,
+  ARTIFICIAL_CONNS, // deprecated, ignored
   TYPEATTEMPTS,
   NARGS,
+  MAXPATH,
   MAX
 };
 
@@ -97,8 +100,9 @@ enum class MS {
 enum class VA {
   START = int(MS::MAX),
   NGLOBALS,
+  SHAREGLOBALS,
   NIDX,
-  NVATTS,
+  NVATTS, // deprecated, ignored
   USEPERM,
   MAXPERM,
   MAX
@@ -120,14 +124,15 @@ enum class CN {
   BREAKTYPE,
   DEFS,
   USES,
+  BUDGET,
   MAX
 };
 
 // locir level
-enum class LI { START = int(CN::MAX), MAX };
+enum class LI { START = int(CN::MAX), DEREF, PERMUTE, MAX };
 
 // exprir level
-enum class EI { START = int(LI::MAX), MAX };
+enum class EI { START = int(LI::MAX), DEPTH, LEAF, CONSTPROB, OPPROB, MAX };
 
 // probability distribution structures
 
@@ -163,6 +168,9 @@ enum { CNB_BREAK, CNB_CCALL, CNB_ICALL, CNB_MAX };
 // for CN::BREAKTYPE
 enum { CNBR_BREAK, CNBR_CONT, CNBR_RET, CNBR_MAX };
 
+// for EI::OPPROB
+enum { EIO_ADD, EIO_SUB, EIO_MUL, EIO_AND, EIO_OR, EIO_XOR, EIO_NEG, EIO_MAX };
+
 #endif
 
 #if defined(OPREGISTRY)
@@ -193,6 +201,8 @@ OPTSTRING(PGC::VANAME, "default.cf", "Specify varassign name to use");
 OPTBOOL(PGC::STOP_ON_CN, "Stop after control flow graph is ready");
 OPTBOOL(PGC::USECN, "Do not generate control flow graph, use existing");
 OPTSTRING(PGC::CNNAME, "default.cf", "Specify control flow graph name to use");
+OPTBOOL(PGC::STOP_ON_LI, "Stop after locations are ready");
+OPTBOOL(PGC::STOP_ON_EI, "Stop after expressions are ready");
 
 // programm level
 OPTSINGLE(PG::CONSUMERS, 5, "Number of consumer threads");
@@ -230,9 +240,11 @@ OPTDIAP(CG::ADDLEAFS, 10, 15, "Number of additional leaf functions");
 OPTPFLAG(CG::SELFLOOP, 6, 100, "Probability to create self-loop");
 OPTDIAP(CG::INDSETCNT, 6, 9, "Number of vertices to allow indirect calls");
 OPTSINGLE(CG::ARTIFICIAL_CONNS, 5,
-          "Artificial connections in case of no zero in-degree edges");
+          "Deprecated, ignored: components are connected from SCC heads");
 OPTSINGLE(CG::TYPEATTEMPTS, 10, "# of attempts to pick random type");
 OPTDIAP(CG::NARGS, 0, 5, "# of function arguments");
+OPTSINGLE(CG::MAXPATH, 0,
+          "Longest call path without indirect calls, 0 means unlimited");
 
 // function-wise metastructure
 OPTPFLAG(MS::USEFLOAT, 10, 100,
@@ -251,8 +263,9 @@ OPTDIAP(MS::NVARS, 5, 20,
 
 // varassign level
 OPTSINGLE(VA::NGLOBALS, 10, "Number of globals out of starting");
+OPTBOOL(VA::SHAREGLOBALS, "Same globals for all varassign randomizations");
 OPTSINGLE(VA::NIDX, 5, "Number of free indexes for function");
-OPTSINGLE(VA::NVATTS, 50, "Number of attemps to choose locals");
+OPTSINGLE(VA::NVATTS, 50, "Deprecated, ignored: locals need no attempts");
 OPTPFLAG(VA::USEPERM, 10, 100, "Probability to add permutator to array");
 OPTSINGLE(VA::MAXPERM, 6, "Maximum number of index permutations");
 
@@ -273,6 +286,22 @@ OPTPROBF(CN::BREAKTYPE, (probf_t{40, 80, 100}), CNBR_MAX,
          "Probability function for breaktypes");
 OPTDIAP(CN::DEFS, 2, 4, "Number of defs");
 OPTDIAP(CN::USES, 4, 6, "Number of uses");
+OPTSINGLE(CN::BUDGET, 0,
+          "Worst-case executed blocks and calls per function with its "
+          "callees (recursion not counted), 0 means unlimited");
+
+// locir level
+OPTPFLAG(LI::DEREF, 70, 100,
+         "Probability to follow pointer to its pointee in location");
+OPTPFLAG(LI::PERMUTE, 50, 100,
+         "Probability to access array through its permutator");
+
+// exprir level
+OPTDIAP(EI::DEPTH, 1, 4, "Maximum depth of expression trees");
+OPTPFLAG(EI::LEAF, 30, 100, "Probability to stop expression before depth");
+OPTPFLAG(EI::CONSTPROB, 20, 100, "Probability of constant expression leaf");
+OPTPROBF(EI::OPPROB, (probf_t{25, 45, 60, 70, 80, 90, 100}), EIO_MAX,
+         "Probability function for expression operations");
 
 #undef OPTPFLAG
 #undef OPTPROBF
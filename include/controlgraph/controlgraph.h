@@ -47,6 +47,7 @@
 #include <iostream>
 #include <list>
 #include <memory>
+#include <string_view>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -77,6 +78,16 @@ class controlgraph_t final {
 
   std::vector<stt> strees_;
 
+  // CN::BUDGET is for main with everything it calls. Every function gets
+  // share of its callers budgets in budget_ and is built in waves, callees
+  // first: wave of function is longest chain of real calls from it to leaf,
+  // not counting calls inside SCC. total_ is worst-case cost of built
+  // function with its callees (see costmodel.h), so callers may check their
+  // budget against it. Without CN::BUDGET all are 0 and there is one wave
+  std::vector<cost_t> budget_;
+  std::vector<int> wave_;
+  std::vector<cost_t> total_;
+
   // public interface
 public:
   explicit controlgraph_t(cfg::config &&, std::shared_ptr<tg::typegraph_t>,
@@ -93,13 +104,30 @@ public:
   vertex_iter_t begin_childs(int nfunc, vertex_t parent) const;
   vertex_iter_t end_childs(int nfunc, vertex_t parent) const;
 
-  shared_vp_t from_vertex(int nfunc, vertex_t) const;
-  std::string varname(int nfunc, int vid) const;
+  vertexprop_t from_vertex(int nfunc, vertex_t) const;
+  std::string_view varname(int vid) const;
 
   // get random call target from call graph or -1 if no available
-  int random_callee(int nfunc, call_type_t) const;
+  // indirect callee is checked by callgraph may_call_indirect, so indirect
+  // calls never take part in recursion. With budget it is also built
+  // before nfunc, so its cost is known
+  // randomness comes from cf, so callers may use own streams
+  int random_callee(int nfunc, call_type_t, const cfg::config &cf) const;
+
+  // budget of split tree: worst-case cost of function with its callees,
+  // 0 means unlimited
+  cost_t budget(int nfunc) const { return budget_[nfunc]; }
+
+  // cost of callee with everything it calls, as seen while building caller:
+  // 0 without budget or if callee is not built yet (recursion)
+  cost_t callee_cost(int caller, int callee) const {
+    return wave_[callee] < wave_[caller] ? total_[callee] : 0;
+  }
 
   void dump(std::ostream &os) const;
+
+private:
+  void plan_budget(cost_t total);
 };
 
 } // namespace cn
@@ -11,15 +11,19 @@
 
 #pragma once
 
+#include <cassert>
+#include <cstdint>
 #include <iostream>
-#include <list>
+#include <iterator>
+#include <limits>
 #include <memory>
-#include <unordered_map>
-#include <unordered_set>
+#include <string_view>
 #include <utility>
+#include <variant>
 #include <vector>
 
 #include "config/configs.h"
+#include "utils/semitree.h"
 #include "varassign/variable.h"
 
 namespace cn {
@@ -27,6 +31,25 @@ namespace cn {
 using vertex_t = int;
 constexpr vertex_t ILLEGAL_VERTEX = -1;
 
+// worst-case dynamic counts (see costmodel.h) quickly overflow anything, so
+// arithmetic on them saturates at COST_INF
+using cost_t = std::uint64_t;
+constexpr cost_t COST_INF = std::numeric_limits<cost_t>::max();
+
+inline cost_t cost_add(cost_t a, cost_t b) {
+  return (a > COST_INF - b) ? COST_INF : a + b;
+}
+
+inline cost_t cost_mul(cost_t a, cost_t b) {
+  return (a != 0 && b > COST_INF / a) ? COST_INF : a * b;
+}
+
+// saturated value is sticky: we do not know how much it was
+inline cost_t cost_sub(cost_t a, cost_t b) {
+  assert(a >= b);
+  return (a == COST_INF) ? COST_INF : a - b;
+}
+
 enum class category_t {
   ILLEGAL = -1,
   BLOCK = 0,
@@ -58,6 +81,13 @@ struct loop_t {
   static constexpr category_t cat = category_t::LOOP;
   int start, stop, step;
   loop_t(int from, int to, int s) : start(from), stop(to), step(s) {}
+
+  // number of iterations, loop is from start while less than stop
+  int trips() const {
+    if (step <= 0 || stop <= start)
+      return 0;
+    return (stop - start + step - 1) / step;
+  }
 };
 
 struct if_t {
@@ -99,71 +129,171 @@ struct split_tree_deleter_t {
 
 using stt = std::unique_ptr<split_tree_t, split_tree_deleter_t>;
 
-// vertexprop is rather large, so real operating type is shared-pointer to it
-// see shared_vp_t below
-class vertexprop_t {
-  const split_tree_t &parent_; // FIXME: is this really needed?
-  category_t cat_ = category_t::ILLEGAL;
-  common_t type_;
-
-  std::vector<va::variable_t> defs_;
-  std::vector<va::variable_t> uses_;
+// compact node record, split tree keeps them in per-function arena indexed
+// by vertex. Defs and uses are not here, they are packed by split tree
+struct node_t {
+  category_t cat = category_t::ILLEGAL;
+  common_t type;
 
-public:
-  using vait = typename std::vector<va::variable_t>::const_iterator;
+  node_t() = default;
+  node_t(category_t c, common_t t) : cat(c), type(t) {}
 
-  vertexprop_t() = delete;
-  explicit vertexprop_t(const split_tree_t &p, category_t c, common_t t)
-      : parent_(p), cat_(c), type_(t) {}
-
-  vertexprop_t(const vertexprop_t &) = delete;
-  vertexprop_t &operator=(const vertexprop_t &) = delete;
-
-  category_t cat() const { return cat_; }
-  common_t type() const { return type_; }
-  bool is_block() const { return cat_ == category_t::BLOCK; }
+  bool is_block() const { return cat == category_t::BLOCK; }
 
   // pseudo-nodes like if may have no uses
   // every branching have (last one may ignore though)
   bool allow_uses() const {
-    return cat_ != category_t::IF && cat_ != category_t::SWITCH &&
-           cat_ != category_t::REGION;
+    return cat != category_t::IF && cat != category_t::SWITCH &&
+           cat != category_t::REGION;
   }
 
   bool allow_defs() const {
-    return cat_ == category_t::BLOCK || cat_ == category_t::CALL;
+    return cat == category_t::BLOCK || cat == category_t::CALL;
   }
+
   bool is_branching() const {
-    return cat_ == category_t::IF || cat_ == category_t::SWITCH ||
-           cat_ == category_t::REGION;
+    return cat == category_t::IF || cat == category_t::SWITCH ||
+           cat == category_t::REGION;
   }
+};
 
-  vait defs_begin() const { return defs_.cbegin(); }
-  vait defs_end() const { return defs_.cend(); }
-  vait uses_begin() const { return uses_.cbegin(); }
-  vait uses_end() const { return uses_.cend(); }
-  std::string varname(va::variable_t v) const;
-
-  void add_var(int cntp, va::variable_t v) {
-    if (cntp == int(CN::DEFS))
-      defs_.push_back(v);
-    else
-      uses_.push_back(v);
+// summary of node (strict) ancestors, split tree fills it when node is
+// inserted, so questions like "are we inside loop" are O(1)
+struct nesting_t {
+  int loop_depth = 0;
+  vertex_t inner_loop = ILLEGAL_VERTEX;
+  unsigned cats = 0; // bit per category of ancestors
+  cost_t weight = 1; // product of trip counts of enclosing loops
+
+  static_assert(int(category_t::CATMAX) <= 32);
+  static constexpr unsigned bit(category_t c) { return 1u << int(c); }
+
+  bool inside(category_t c) const { return cats & bit(c); }
+
+  // nesting for childs of node v with record n and this nesting
+  // pseudo root has illegal category and adds nothing
+  nesting_t child(vertex_t v, const node_t &n) const {
+    nesting_t res = *this;
+    if (n.cat == category_t::ILLEGAL)
+      return res;
+    res.cats |= bit(n.cat);
+    if (n.cat == category_t::LOOP) {
+      res.loop_depth += 1;
+      res.inner_loop = v;
+      res.weight = cost_mul(weight, std::get<loop_t>(n.type).trips());
+    }
+    return res;
   }
 };
 
-using shared_vp_t = std::shared_ptr<const vertexprop_t>;
-using vct = std::vector<shared_vp_t>;
-using vcit = typename vct::iterator;
+// view of node together with its defs and uses
+// cheap to copy, valid while split tree it came from is alive
+class vertexprop_t {
+  const split_tree_t *parent_;
+  const node_t *node_;
+  const nesting_t *nest_;
+  const va::variable_t *defs_, *uses_, *uses_end_;
+
+public:
+  using vait = const va::variable_t *;
+
+  vertexprop_t(const split_tree_t &p, const node_t &n, const nesting_t &nest,
+               vait defs, vait uses, vait uses_end)
+      : parent_(&p), node_(&n), nest_(&nest), defs_(defs), uses_(uses),
+        uses_end_(uses_end) {}
+
+  category_t cat() const { return node_->cat; }
+  const common_t &type() const { return node_->type; }
+  bool is_block() const { return node_->is_block(); }
+  bool allow_uses() const { return node_->allow_uses(); }
+  bool allow_defs() const { return node_->allow_defs(); }
+  bool is_branching() const { return node_->is_branching(); }
+  const nesting_t &nesting() const { return *nest_; }
+
+  vait defs_begin() const { return defs_; }
+  vait defs_end() const { return uses_; }
+  vait uses_begin() const { return uses_; }
+  vait uses_end() const { return uses_end_; }
+  std::string_view varname(va::variable_t v) const;
+};
+
+using vct = std::vector<node_t>;
+using vcit = typename vct::const_iterator;
 
 std::ostream &operator<<(std::ostream &, const vertexprop_t &);
 
-template <typename T, typename... Ts>
-shared_vp_t create_vprop(const split_tree_t &p, Ts &&...args) {
-  return std::make_shared<const vertexprop_t>(p, T::cat,
-                                              T(std::forward<Ts>(args)...));
+template <typename T, typename... Ts> node_t create_vprop(Ts &&...args) {
+  return node_t(T::cat, T(std::forward<Ts>(args)...));
 }
 
-using vertex_iter_t = typename std::list<vertex_t>::const_iterator;
+// split tree nodes live on intrusive semitree. Any block can be turned into
+// container later, so all control nodes are branches, leafs are never created
+class ctl_node_t;
+
+class ctl_leaf_t : public semitree::leaf_t<ctl_leaf_t, ctl_node_t> {};
+
+class ctl_node_t : public semitree::branch_t<ctl_leaf_t, ctl_node_t> {
+  vertex_t v_;
+
+public:
+  // record is named with namespace, node_t alone is semitree base here
+  cn::node_t rec;
+  nesting_t nest;
+
+  ctl_node_t(vertex_t v, cn::node_t r) : v_(v), rec(r) {}
+  vertex_t vertex() const { return v_; }
+};
+
+using ctl_base_t = semitree::node_t<ctl_leaf_t, ctl_node_t>;
+
+inline vertex_t vertex_of(const ctl_base_t &n) {
+  return static_cast<const ctl_node_t &>(n).vertex();
+}
+
+// sibling iterator over control nodes, dereferences to their vertices
+class vertex_iter_t {
+  using sibling_iterator_t =
+      semitree::const_sibling_iterator_t<ctl_leaf_t, ctl_node_t>;
+  sibling_iterator_t it_;
+
+public:
+  using difference_type = std::ptrdiff_t;
+  using value_type = vertex_t;
+  using pointer = const vertex_t *;
+  using reference = vertex_t;
+  using iterator_category = std::bidirectional_iterator_tag;
+
+  vertex_iter_t() = default;
+  explicit vertex_iter_t(sibling_iterator_t it) : it_(it) {}
+
+  vertex_t operator*() const { return vertex_of(*it_); }
+
+  vertex_iter_t &operator++() {
+    ++it_;
+    return *this;
+  }
+  vertex_iter_t operator++(int) {
+    auto it{*this};
+    ++it_;
+    return it;
+  }
+
+  vertex_iter_t &operator--() {
+    --it_;
+    return *this;
+  }
+  vertex_iter_t operator--(int) {
+    auto it{*this};
+    --it_;
+    return it;
+  }
+
+  friend bool operator==(vertex_iter_t lhs, vertex_iter_t rhs) {
+    return lhs.it_ == rhs.it_;
+  }
+  friend bool operator!=(vertex_iter_t lhs, vertex_iter_t rhs) {
+    return lhs.it_ != rhs.it_;
+  }
+};
 
 } // namespace cn
@@ -0,0 +1,66 @@
+//------------------------------------------------------------------------------
+//
+// Static runtime cost model for controlgraph
+//
+// Estimates worst-case number of executed blocks and calls: every node is
+// weighted by product of trip counts of enclosing loops (see nesting_t),
+// conditions are assumed to take every branch, breaks are ignored.
+//
+// Function cost is its body cost plus cost of every callee multiplied by
+// weight of call. Recursion makes worst case unbounded: calls closing
+// cycles are counted, but callee cost is not added again. Totals of
+// recursive functions and everything calling them are lower bounds.
+//
+// Costs saturate at COST_INF.
+//
+//------------------------------------------------------------------------------
+//
+// This file is licensed after LGPL v3
+// Look at: https://www.gnu.org/licenses/lgpl-3.0.en.html for details
+//
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <iostream>
+#include <vector>
+
+#include "controltypes.h"
+
+namespace cg {
+class callgraph_t;
+}
+
+namespace cn {
+
+class controlgraph_t;
+
+struct dyncost_t {
+  cost_t blocks = 0;
+  cost_t calls = 0;
+};
+
+class cost_model_t final {
+  std::vector<dyncost_t> body_;
+  std::vector<dyncost_t> total_;
+  std::vector<char> exact_;
+  int main_ = 0;
+
+public:
+  cost_model_t(const controlgraph_t &cn, const cg::callgraph_t &cg);
+
+  // function body only
+  const dyncost_t &body(int nfunc) const { return body_[nfunc]; }
+
+  // function with everything it calls
+  const dyncost_t &total(int nfunc) const { return total_[nfunc]; }
+  bool exact(int nfunc) const { return exact_[nfunc]; }
+
+  // whole program, i.e. main function total
+  const dyncost_t &program() const { return total_[main_]; }
+  bool program_exact() const { return exact_[main_]; }
+
+  void dump(std::ostream &os) const;
+};
+
+} // namespace cn
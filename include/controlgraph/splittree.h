@@ -11,12 +11,10 @@
 
 #pragma once
 
+#include <cassert>
 #include <iostream>
-#include <list>
 #include <memory>
-#include <stack>
-#include <unordered_map>
-#include <unordered_set>
+#include <string_view>
 #include <utility>
 #include <vector>
 
@@ -30,7 +28,7 @@ namespace cn {
 
 class controlgraph_t;
 
-using itpos_t = std::list<vertex_t>::iterator;
+using itpos_t = semitree::sibling_iterator_t<ctl_leaf_t, ctl_node_t>;
 
 class split_tree_t {
   const controlgraph_t &parent_;
@@ -44,42 +42,68 @@ class split_tree_t {
   // number of function, this split tree is about in parent
   int nfunc_;
 
-  // adjacency lists for vertices
-  // we have special illegal vertex 0, adj list of which is
+  // per-function pool of tree nodes, vertex is index in pool
+  // we have special pseudo vertex 0, childs of which are
   // all top-level vertices
   static constexpr int PSEUDO_VERTEX = 0;
+  semitree::node_pool_t<ctl_node_t> pool_;
 
-  std::vector<std::list<vertex_t>> adj_;
-  std::unordered_map<vertex_t, vertex_t> parent_of_;
-  std::unordered_map<vertex_t, shared_vp_t> desc_of_;
-  std::unordered_set<vertex_t> bbs_;
+  // defs and uses of all nodes in CSR form: defs of v are
+  // [var_offs_[2v], var_offs_[2v + 1]), uses follow up to var_offs_[2v + 2]
+  std::vector<int> var_offs_;
+  std::vector<va::variable_t> vars_;
+
+  // basic blocks in no particular order, bbidx_[v] is index of v in bbs_
+  // or -1 if v is not basic block
+  std::vector<vertex_t> bbs_;
+  std::vector<int> bbidx_;
+
+  // worst-case dynamic count of blocks and calls executed by function with
+  // its callees (see costmodel.h), kept not greater than budget unless
+  // budget is 0. Direct call seeds are mandatory and may exceed it
+  cost_t cost_ = 0;
+  cost_t budget_ = 0;
 
 public:
+  // cf is copied and reseeded, so tree gets own random stream
   split_tree_t(const controlgraph_t &p, const cfg::config &cf,
-               std::shared_ptr<va::varassign_t> va, int nfunc);
+               std::shared_ptr<va::varassign_t> va, int nfunc, int seed);
 
   void process(vcit start, vcit fin);
 
   // toplevel iterator
-  vertex_iter_t begin() const { return adj_[PSEUDO_VERTEX].begin(); }
-  vertex_iter_t end() const { return adj_[PSEUDO_VERTEX].end(); }
+  vertex_iter_t begin() const { return begin_childs(PSEUDO_VERTEX); }
+  vertex_iter_t end() const { return end_childs(PSEUDO_VERTEX); }
 
   // childs iterator
   vertex_iter_t begin_childs(vertex_t parent) const {
-    return adj_[parent].begin();
+    return vertex_iter_t{pool_[parent].begin()};
+  }
+
+  vertex_iter_t end_childs(vertex_t parent) const {
+    return vertex_iter_t{pool_[parent].end()};
   }
 
-  vertex_iter_t end_childs(vertex_t parent) const { return adj_[parent].end(); }
+  vertexprop_t from_vertex(vertex_t v) const;
 
-  shared_vp_t from_vertex(vertex_t v) const;
+  cost_t cost() const { return cost_; }
 
-  std::string varname(va::variable_t v) const;
+  std::string_view varname(va::variable_t v) const;
 
   // tree-like print of controlgraph
   void dump(std::ostream &os) const;
 
   // split helpers
 private:
+  vertex_t add_node(const node_t &rec);
+  vertex_t parent_of(vertex_t v) const;
+  void nest_under(vertex_t v, vertex_t parent);
+  cost_t node_cost(vertex_t v) const;
+  void count(vertex_t v);
+  void uncount(vertex_t v);
+  int fits(cost_t weight) const;
+  void bb_insert(vertex_t v);
+  void bb_erase(vertex_t v);
   itpos_t add_block(itpos_t pos, vertex_t parent);
 
   template <typename T, typename... Args>
@@ -89,8 +113,9 @@ private:
   void add_container(int bb_under_split);
   void add_special(int bb_under_split);
   void do_split(int bb_under_split);
-  void add_vars(int cntp, shared_vp_t svp);
-  void assign_vars_to(shared_vp_t svp);
+  void add_vars(int cntp);
+  void assign_vars_to(const node_t &n);
+  void add_accblocks();
 };
 
 //------------------------------------------------------------------------------
@@ -102,11 +127,16 @@ private:
 // turns anything at nblock into T
 template <typename T, typename... Args>
 void split_tree_t::turn_block(int nblock, Args &&...args) {
-  desc_of_[nblock] = create_vprop<T>(*this, std::forward<Args>(args)...);
+  // nesting of childs is taken at their insertion, so container shall
+  // get its category before childs
+  assert(T::cat == category_t::BLOCK || pool_[nblock].empty());
+  uncount(nblock);
+  pool_[nblock].rec = create_vprop<T>(std::forward<Args>(args)...);
+  count(nblock);
   if constexpr (T::cat != category_t::BLOCK) {
-    bbs_.erase(nblock);
+    bb_erase(nblock);
   } else {
-    bbs_.insert(nblock);
+    bb_insert(nblock);
   }
 }
 
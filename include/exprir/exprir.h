@@ -0,0 +1,145 @@
+//------------------------------------------------------------------------------
+//
+// ExprIR: arithmetic expressions over LocIR locations
+//
+// Every block def gets expression tree, leafs of which are block uses and
+// constants. Branchings get condition over their uses. Operations and
+// constants are limited by function metastructure (float, signed). Integer
+// arithmetic wraps (see is_wrapping), so any operands are fine.
+//
+// Expressions of node are stored in postfix array: operands always precede
+// operation and are referenced by index, so common subexpression is stored
+// once and every expression is just index of its root:
+//
+// v3 = (v1 + g2) * (v1 + g2)
+//
+// 0: LOC v1
+// 1: LOC g2
+// 2: ADD 0 1
+// 3: MUL 2 2
+// v3 <- 3
+//
+// All IR for one randomization lives in its own arena, like for LocIR
+//
+//------------------------------------------------------------------------------
+//
+// This file is licensed after LGPL v3
+// Look at: https://www.gnu.org/licenses/lgpl-3.0.en.html for details
+//
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "config/configs.h"
+#include "controlgraph/controltypes.h"
+#include "locir/locir.h"
+#include "utils/arena.h"
+
+namespace tg {
+class typegraph_t;
+}
+
+namespace cg {
+class callgraph_t;
+}
+
+namespace ei {
+
+enum class op_t : unsigned char {
+  LOC = 0,
+  CONST,
+  CAST,
+  NEG,
+  ADD,
+  SUB,
+  MUL,
+  AND,
+  OR,
+  XOR,
+  OPMAX
+};
+
+// C spelling of unary and binary operations, empty for others
+const char *op_name(op_t op);
+
+// NEG, ADD, SUB and MUL on integers wrap: they are done modulo 2^64 and
+// truncated to result type. Plain C operator overflows signed types (and
+// small unsigned ones, promoted to int), which is UB, so printers shall do
+// them in unsigned long long
+bool is_wrapping(op_t op);
+
+// LOC: a is use number in node
+// CONST: a is value
+// CAST, NEG: a is operand index
+// binary: a and b are operand indexes
+struct enode_t {
+  op_t op;
+  int type_id;
+  int a = -1;
+  int b = -1;
+};
+
+// def is def number in node or -1 for branching condition
+struct assign_t {
+  int def;
+  int root;
+};
+
+struct node_exprs_t {
+  const li::node_locs_t *locs = nullptr;
+  int nexprs = 0;
+  int nassigns = 0;
+  const enode_t *exprs = nullptr;
+  const assign_t *assigns = nullptr;
+};
+
+class exprir_t final {
+  cfg::config config_;
+  std::shared_ptr<tg::typegraph_t> tgraph_;
+  std::shared_ptr<cg::callgraph_t> cgraph_;
+  std::shared_ptr<li::locir_t> locir_;
+
+  // everything below points here
+  utils::arena_t arena_;
+
+  struct func_exprs_t {
+    const node_exprs_t *nodes = nullptr;
+    int nnodes = 0;
+  };
+  std::vector<func_exprs_t> funcs_;
+
+  // public interface
+public:
+  explicit exprir_t(cfg::config &&, std::shared_ptr<tg::typegraph_t>,
+                    std::shared_ptr<cg::callgraph_t>,
+                    std::shared_ptr<li::locir_t>);
+
+  int nfuncs() const { return funcs_.size(); }
+
+  // nodes with expressions in preorder
+  const node_exprs_t *begin(int nfunc) const { return funcs_[nfunc].nodes; }
+  const node_exprs_t *end(int nfunc) const {
+    return funcs_[nfunc].nodes + funcs_[nfunc].nnodes;
+  }
+
+  const li::locir_t &locir() const { return *locir_; }
+
+  // bytes taken by IR
+  std::size_t memory_used() const { return arena_.used(); }
+
+  // infix form of expression n of node
+  void print_expr(std::ostream &os, const node_exprs_t &ne, int n) const;
+  void dump(std::ostream &os) const;
+
+  // helpers
+private:
+  struct func_builder;
+  void build_function(int nfunc, func_builder &fb);
+};
+
+} // namespace ei
@@ -0,0 +1,95 @@
+//------------------------------------------------------------------------------
+//
+// C printer: final program from ExprIR
+//
+// Program is printed as:
+// * includes and ftoi helper
+// * typedefs for all types (scalars, forward struct declarations, then
+//   arrays, pointers and struct bodies, every type after its parts)
+// * globals, recursion budget counter and prototypes of all functions
+// * function definitions grouped by callgraph modules
+// * main calling main function of callgraph
+//
+// Every function is printed by its own task into its own buffer, header and
+// main are two more such tasks, then buffers are written to sink in module
+// order.
+// Printing streams tokens right into buffers, nothing is built in strings.
+//
+// Array indexes are taken modulo array size and dereference is printed as
+// its pointee variable, so every access is in bounds. Locals are
+// zero-initialized. Integer arithmetic is printed unsigned, so it
+// never overflows signed type, and floats are converted to integers by
+// ftoi, which maps out of range values (and NaN) to zero
+//
+//------------------------------------------------------------------------------
+//
+// This file is licensed after LGPL v3
+// Look at: https://www.gnu.org/licenses/lgpl-3.0.en.html for details
+//
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "controlgraph/controltypes.h"
+#include "exprir/exprir.h"
+#include "locir/locir.h"
+
+namespace tg {
+class typegraph_t;
+}
+
+namespace cg {
+class callgraph_t;
+}
+
+namespace va {
+class varassign_t;
+}
+
+namespace lp {
+
+// wrapping integer arithmetic (see ei::is_wrapping), a and b print operands:
+// ((T1)((unsigned long long)(a) + (unsigned long long)(b)))
+// NEG is printed as 0 - a
+template <typename FA, typename FB>
+void print_wrapping(std::ostream &os, std::string_view tname, const char *op,
+                    FA a, FB b) {
+  os << "((" << tname << ")((unsigned long long)(";
+  a();
+  os << ") " << op << " (unsigned long long)(";
+  b();
+  os << ")))";
+}
+
+class cprinter_t final {
+  std::shared_ptr<tg::typegraph_t> tgraph_;
+  std::shared_ptr<cg::callgraph_t> cgraph_;
+  std::shared_ptr<va::varassign_t> vassign_;
+  std::shared_ptr<ei::exprir_t> exprir_;
+
+public:
+  cprinter_t(std::shared_ptr<tg::typegraph_t>,
+             std::shared_ptr<cg::callgraph_t>,
+             std::shared_ptr<va::varassign_t>, std::shared_ptr<ei::exprir_t>);
+
+  // whole program to os, returns number of bytes written
+  std::size_t print(std::ostream &os) const;
+
+  // helpers
+private:
+  struct func_printer;
+  void print_header(std::ostream &os) const;
+  void print_function(std::ostream &os, int nfunc) const;
+  void print_main(std::ostream &os) const;
+  bool print_type(std::ostream &os, int tid, std::vector<char> &state) const;
+  void print_signature(std::ostream &os, int nfunc) const;
+  void print_pointer(std::ostream &os, int nfunc, const char *name) const;
+};
+
+} // namespace lp
@@ -0,0 +1,130 @@
+//------------------------------------------------------------------------------
+//
+// LocIR: concrete locations for control graph defs and uses
+//
+// Control graph knows only which variables are defined and used by node.
+// LocIR decides, where exactly inside variable access goes:
+//
+// v3           -- scalar variable itself
+// v3.f1[i5]    -- field path to array element via accessor index
+// g2[p7[i5]]   -- array element via permutator
+// (*v4.f0).f2  -- dereference of pointer field, pointee is known variable
+//
+// Every location is variable (with its memory slot: global, local or
+// argument) and path of steps, ending at scalar type or at pointer, which
+// is not followed.
+//
+// All IR for one randomization lives in its own arena and is released in one
+// step with locir object. Nodes of function are in preorder of control graph
+//
+//------------------------------------------------------------------------------
+//
+// This file is licensed after LGPL v3
+// Look at: https://www.gnu.org/licenses/lgpl-3.0.en.html for details
+//
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "config/configs.h"
+#include "controlgraph/controltypes.h"
+#include "utils/arena.h"
+
+namespace tg {
+class typegraph_t;
+}
+
+namespace va {
+class varassign_t;
+}
+
+namespace cn {
+class controlgraph_t;
+}
+
+namespace li {
+
+// memory slot of variable
+enum class storage_t : unsigned char { GLOBAL, LOCAL, ARG };
+
+enum class step_kind_t : unsigned char { FIELD, INDEX, DEREF };
+
+// FIELD: arg is field number
+// INDEX: arg is index variable (-1 for constant 0), perm is permutator or -1
+// DEREF: arg is pointee variable, further steps are inside it
+struct step_t {
+  step_kind_t kind;
+  int arg;
+  int perm = -1;
+};
+
+struct loc_t {
+  int var = -1;
+  storage_t storage = storage_t::LOCAL;
+  int type_id = -1; // type at the end of path
+  int npath = 0;
+  const step_t *path = nullptr;
+
+  const step_t *begin() const { return path; }
+  const step_t *end() const { return path + npath; }
+};
+
+// locations of single control graph node
+struct node_locs_t {
+  cn::vertex_t v = cn::ILLEGAL_VERTEX;
+  int ndefs = 0;
+  int nuses = 0;
+  const loc_t *defs = nullptr;
+  const loc_t *uses = nullptr;
+};
+
+class locir_t final {
+  cfg::config config_;
+  std::shared_ptr<tg::typegraph_t> tgraph_;
+  std::shared_ptr<va::varassign_t> vassign_;
+  std::shared_ptr<cn::controlgraph_t> contgraph_;
+
+  // everything below points here
+  utils::arena_t arena_;
+
+  struct func_locs_t {
+    const node_locs_t *nodes = nullptr;
+    int nnodes = 0;
+  };
+  std::vector<func_locs_t> funcs_;
+
+  // public interface
+public:
+  explicit locir_t(cfg::config &&, std::shared_ptr<tg::typegraph_t>,
+                   std::shared_ptr<va::varassign_t>,
+                   std::shared_ptr<cn::controlgraph_t>);
+
+  int nfuncs() const { return funcs_.size(); }
+
+  // nodes having defs or uses, in preorder
+  const node_locs_t *begin(int nfunc) const { return funcs_[nfunc].nodes; }
+  const node_locs_t *end(int nfunc) const {
+    return funcs_[nfunc].nodes + funcs_[nfunc].nnodes;
+  }
+
+  const cn::controlgraph_t &controlgraph() const { return *contgraph_; }
+
+  // bytes taken by IR
+  std::size_t memory_used() const { return arena_.used(); }
+
+  void print_loc(std::ostream &os, const loc_t &l) const;
+  void dump(std::ostream &os) const;
+
+  // helpers
+private:
+  struct func_scratch;
+  void build_function(int nfunc, func_scratch &fs);
+  loc_t make_loc(int nfunc, va::variable_t var, func_scratch &fs);
+};
+
+} // namespace li
@@ -28,6 +28,7 @@
 #include <optional>
 #include <set>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
@@ -38,6 +39,7 @@
 #include "config/configs.h"
 #include "typecats.h"
 #include "typeiters.h"
+#include "utils/string_arena.h"
 
 namespace tg {
 
@@ -64,6 +66,9 @@ private:
   // subset of leaf_vs_: integral scalar leafs
   std::set<vertex_t> idx_vs_;
 
+  // short names of types, indexed by type id
+  utils::string_arena_t names_;
+
   // typegraph public interface
 public:
   explicit typegraph_t(cfg::config &&);
@@ -76,6 +81,9 @@ public:
   // vertex properties from vertex descriptor
   vertexprop_t vertex_from(vertex_t v) const { return graph_[v]; }
 
+  // short name like A5, see vertexprop_t::get_short_name
+  std::string_view short_name(int tid) const { return names_[tid]; }
+
   // property iterator
   ct_iterator_t begin_types() const;
   ct_iterator_t end_types() const;
@@ -92,14 +100,23 @@ public:
   int ntypes() const { return boost::num_vertices(graph_); }
 
   // random getters public interface
+  // overloads with config take randomness from it, not from typegraph
+  // (so several threads may query typegraph with their own configs)
 public:
-  vertexprop_t get_random_type() const;
+  vertexprop_t get_random_type() const { return get_random_type(config_); }
+  vertexprop_t get_random_type(const cfg::config &cf) const;
 
   // random type, that can be used as index (like int)
-  vertexprop_t get_random_index_type() const;
+  vertexprop_t get_random_index_type() const {
+    return get_random_index_type(config_);
+  }
+  vertexprop_t get_random_index_type(const cfg::config &cf) const;
 
   // random type, that can be used as permutation (like array of int)
-  vertexprop_t get_random_perm_type(int nelems) const;
+  vertexprop_t get_random_perm_type(int nelems) const {
+    return get_random_perm_type(config_, nelems);
+  }
+  vertexprop_t get_random_perm_type(const cfg::config &cf, int nelems) const;
 
   // convenience getters
 public:
@@ -122,6 +139,7 @@ private:
   void process_pointer(vertex_t v);
   void create_bitfields();
   void choose_perms_idxs();
+  void intern_names();
 };
 
 } // namespace tg
@@ -0,0 +1,121 @@
+//------------------------------------------------------------------------------
+//
+// Arena: monotonic storage for IR built by single task
+//
+// Objects are bumped one after another in big chunks and never freed
+// individually, whole arena is released in one step when IR dies. Only
+// trivially destructible objects may live here, destructors are not called
+//
+// utils::arena_t arena;
+// auto *p = arena.create<point_t>(1, 2);
+// auto *a = arena.create_array<int>(10); // value-initialized
+// arena.release(); // p and a are gone
+//
+// Arena is not thread-safe, every task shall have its own
+//
+//------------------------------------------------------------------------------
+//
+// This file is licensed after LGPL v3
+// Look at: https://www.gnu.org/licenses/lgpl-3.0.en.html for details
+//
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace utils {
+
+class arena_t {
+  std::vector<std::unique_ptr<std::byte[]>> chunks_;
+  std::size_t chunk_size_;
+  std::byte *cur_ = nullptr;
+  std::byte *end_ = nullptr;
+  std::size_t used_ = 0;
+
+public:
+  static constexpr std::size_t DEFAULT_CHUNK = 64 * 1024;
+
+  explicit arena_t(std::size_t chunk_size = DEFAULT_CHUNK)
+      : chunk_size_(chunk_size) {}
+
+  arena_t(const arena_t &) = delete;
+  arena_t &operator=(const arena_t &) = delete;
+  arena_t(arena_t &&) = default;
+  arena_t &operator=(arena_t &&) = default;
+
+  // raw memory, align shall be power of two
+  void *allocate(std::size_t size, std::size_t align) {
+    assert(align != 0 && (align & (align - 1)) == 0);
+    auto p = reinterpret_cast<std::uintptr_t>(cur_);
+    std::size_t pad = (align - p % align) % align;
+    if (cur_ == nullptr || size + pad > std::size_t(end_ - cur_)) {
+      grow(size + align);
+      p = reinterpret_cast<std::uintptr_t>(cur_);
+      pad = (align - p % align) % align;
+    }
+    std::byte *res = cur_ + pad;
+    cur_ = res + size;
+    used_ += size + pad;
+    return res;
+  }
+
+  template <typename T, typename... Args> T *create(Args &&...args) {
+    static_assert(std::is_trivially_destructible_v<T>,
+                  "Arena never calls destructors");
+    void *mem = allocate(sizeof(T), alignof(T));
+    return new (mem) T(std::forward<Args>(args)...);
+  }
+
+  template <typename T> T *create_array(std::size_t n) {
+    static_assert(std::is_trivially_destructible_v<T>,
+                  "Arena never calls destructors");
+    if (n == 0)
+      return nullptr;
+    T *res = static_cast<T *>(allocate(sizeof(T) * n, alignof(T)));
+    for (std::size_t i = 0; i != n; ++i)
+      new (res + i) T();
+    return res;
+  }
+
+  // copy of n objects from src in arena
+  template <typename T> T *copy(const T *src, std::size_t n) {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "Arena copies objects bytewise");
+    if (n == 0)
+      return nullptr;
+    void *mem = allocate(sizeof(T) * n, alignof(T));
+    return static_cast<T *>(std::memcpy(mem, src, sizeof(T) * n));
+  }
+
+  // drops everything at once
+  void release() {
+    chunks_.clear();
+    cur_ = end_ = nullptr;
+    used_ = 0;
+  }
+
+  // bytes given out (with alignment padding) and number of chunks
+  std::size_t used() const { return used_; }
+  std::size_t nchunks() const { return chunks_.size(); }
+
+private:
+  // big requests get own chunk, current chunk tail is abandoned
+  void grow(std::size_t atleast) {
+    std::size_t sz = std::max(chunk_size_, atleast);
+    chunks_.emplace_back(new std::byte[sz]);
+    cur_ = chunks_.back().get();
+    end_ = cur_ + sz;
+  }
+};
+
+} // namespace utils
@@ -16,6 +16,10 @@
 //   World
 // !
 //
+// Filter works on blocks: text between newlines is passed to sink in one
+// write and indentation is written as run of spaces, so cost is per line,
+// not per character.
+//
 //------------------------------------------------------------------------------
 //
 // This file is licensed after LGPL v3
@@ -28,13 +32,15 @@
 #include <boost/iostreams/filtering_streambuf.hpp>
 #include <boost/iostreams/operations.hpp>
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <ostream>
 #include <streambuf>
 
 namespace utils {
 
-class indent_filter_t : public boost::iostreams::output_filter {
+class indent_filter_t : public boost::iostreams::multichar_output_filter {
   int level_spaces_;
   int cur_spaces_ = 0;
   int remaining_spaces_ = 0;
@@ -54,22 +60,41 @@ public:
     assert(level_spaces_ >= 0 && "Expected non-negative value");
   }
 
-  template <typename Sink> bool put(Sink &sink, char c) {
+  // Returns number of characters consumed from s. Indentation goes
+  // before first character of every line except empty ones, i.e. it is
+  // written only when something but newline follows it.
+  template <typename Sink>
+  std::streamsize write(Sink &sink, const char *s, std::streamsize n) {
     namespace io = boost::iostreams;
-
-    if (c == '\n') {
-      remaining_spaces_ = cur_spaces_;
-      return io::put(sink, c);
+    static constexpr char spaces[] = "                                ";
+    constexpr std::streamsize nspaces = sizeof(spaces) - 1;
+
+    std::streamsize pos = 0;
+    while (pos != n) {
+      while (remaining_spaces_ != 0 && s[pos] != '\n') {
+        // write operation can fail or be partial so we should decrement
+        // spaces only by what was actually written.
+        std::streamsize amt =
+            std::min<std::streamsize>(remaining_spaces_, nspaces);
+        std::streamsize res = io::write(sink, spaces, amt);
+        if (res <= 0)
+          return pos;
+        remaining_spaces_ -= res;
+      }
+
+      // rest of line with its newline (if any) goes in one write
+      const void *nl = std::memchr(s + pos, '\n', n - pos);
+      std::streamsize end = nl ? static_cast<const char *>(nl) - s + 1 : n;
+      std::streamsize res = io::write(sink, s + pos, end - pos);
+      if (res <= 0)
+        return pos;
+      pos += res;
+      if (pos != end)
+        return pos;
+      if (nl)
+        remaining_spaces_ = cur_spaces_;
     }
-
-    while (remaining_spaces_ != 0) {
-      // put operation can fail so we should decrement
-      // spaces only if putting to sink was successful.
-      if (!io::put(sink, ' '))
-        return false;
-      --remaining_spaces_;
-    }
-    return io::put(sink, c);
+    return pos;
   }
 
   void increase_level(int num_levels = 1) {
@@ -97,9 +122,11 @@ class indent_ostreambuf_t : public boost::iostreams::filtering_ostreambuf {
   using base = boost::iostreams::filtering_ostreambuf;
 
   static constexpr int filter_index_ = 0;
+  std::streambuf &next_;
 
 public:
-  indent_ostreambuf_t(std::streambuf &buf, int level_spaces) : base{} {
+  indent_ostreambuf_t(std::streambuf &buf, int level_spaces)
+      : base{}, next_{buf} {
     // Second argument controls buffer size.
     // We need no buffer for our streambuf.
     base::push(indent_filter_t{level_spaces}, 0);
@@ -115,6 +142,13 @@ public:
   int get_current_level() const {
     return component<indent_filter_t>(filter_index_)->get_current_level();
   }
+
+protected:
+  // Chain is unbuffered, so it has nothing pending and block may go right
+  // to filter and then to buf instead of char by char through overflow.
+  std::streamsize xsputn(const char *s, std::streamsize n) override {
+    return component<indent_filter_t>(filter_index_)->write(next_, s, n);
+  }
 };
 
 class indent_ostream_t : private indent_ostreambuf_t, public std::ostream {
@@ -21,8 +21,10 @@
 
 #pragma once
 
+#include "semitree_flat.h"
 #include "semitree_iterator.h"
 #include "semitree_nodes.h"
+#include "semitree_pool.h"
 
 namespace semitree {
 template <typename Leaf, typename Branch>
@@ -42,9 +44,12 @@ public:
   tree_t() = default;
 
   using branch_t::begin;
+  using branch_t::detach;
   using branch_t::empty;
   using branch_t::end;
   using branch_t::insert;
+  using branch_t::move;
+  using branch_t::splice;
 
   // Iterators that denote inorder range of this tree.
   // Inorder range consists of all inserted nodes.
@@ -55,6 +60,11 @@ public:
     return const_inorder_iterator_t{begin(), false};
   }
 
+  // Contiguous snapshot of all inserted nodes, see semitree_flat.h.
+  auto flatten(flatten_order_t order = flatten_order_t::PREORDER) const {
+    return semitree::flatten(static_cast<const branch_t &>(*this), order);
+  }
+
   // Inorder insertion. Inserts BEFORE iterator.
   // Return value: 'it'.
   // Be careful passing inorder_begin from empty branch,
@@ -0,0 +1,85 @@
+//------------------------------------------------------------------------------
+//
+// Definitions for flattened semitree snapshots.
+//
+// Inorder iterator chases parent and sibling pointers over nodes scattered
+// in memory. For read-only passes (dumps, printers, analysis) it is cheaper
+// to walk the tree once and then scan contiguous array.
+//
+// flatten(b, order) lays out all descendants of branch b:
+//
+// PREORDER: every node once, parent before its children.
+// EULER: as inorder iterator, i.e. branch once more after its children,
+//        with visited flag set.
+//
+// Every entry knows its depth (children of b have depth 0) and extent of
+// its subtree: entries [n, end) belong to subtree of entry n, in EULER order
+// including closing entry of branch. So skipping subtree is n = end.
+//
+// Snapshot is not updated on tree changes.
+//
+//------------------------------------------------------------------------------
+//
+// This file is licensed after LGPL v3
+// Look at: https://www.gnu.org/licenses/lgpl-3.0.en.html for details
+//
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cassert>
+#include <vector>
+
+#include "semitree_iterator.h"
+#include "semitree_nodes.h"
+
+namespace semitree {
+
+enum class flatten_order_t { PREORDER, EULER };
+
+template <typename Leaf, typename Branch> struct flat_entry_t {
+  const node_t<Leaf, Branch> *node;
+  int depth;
+  int end;
+  bool visited;
+};
+
+template <typename Leaf, typename Branch>
+using flat_tree_t = std::vector<flat_entry_t<Leaf, Branch>>;
+
+template <typename Leaf, typename Branch>
+flat_tree_t<Leaf, Branch>
+flatten(const branch_t<Leaf, Branch> &b,
+        flatten_order_t order = flatten_order_t::PREORDER) {
+  using inorder_iterator_t = const_inorder_iterator_t<Leaf, Branch>;
+  flat_tree_t<Leaf, Branch> res;
+  std::vector<int> open;
+  int depth = 0;
+
+  inorder_iterator_t it{&b, false}, ie{&b, true};
+  for (++it; it != ie; ++it) {
+    const auto &n = it->ref;
+    if (!it->visited) {
+      int idx = res.size();
+      res.push_back({&n, depth, idx + 1, false});
+      if (n.is_branch()) {
+        open.push_back(idx);
+        depth += 1;
+      }
+      continue;
+    }
+
+    // Closing visited branch. Leafs are never visited going forward.
+    assert(n.is_branch() && !open.empty());
+    depth -= 1;
+    if (order == flatten_order_t::EULER)
+      res.push_back({&n, depth, int(res.size()) + 1, true});
+    res[open.back()].end = res.size();
+    open.pop_back();
+  }
+
+  assert(open.empty());
+  return res;
+}
+
+} // namespace semitree
@@ -142,6 +142,8 @@ class inorder_iterator_base_t final {
       semitree::sibling_iterator_base_t<Leaf, Branch, IsConst>;
 
   using internal_value_type = std::conditional_t<IsConst, const node_t, node_t>;
+  using internal_branch_type =
+      std::conditional_t<IsConst, const branch_t, branch_t>;
   using internal_pointer = internal_value_type *;
   using internal_reference = internal_value_type &;
 
@@ -282,7 +284,7 @@ auto inorder_iterator_base_t<Leaf, Branch, IsConst>::operator++() noexcept
   // Unvisited parent. Go to unvisited firstchild or to
   // visited itself if it is empty parent.
   if (val_.ptr_->is_branch() && !val_.visited_) {
-    auto *parent = static_cast<branch_t *>(val_.ptr_);
+    auto *parent = static_cast<internal_branch_type *>(val_.ptr_);
     if (parent->empty())
       val_.visited_ = true;
     else
@@ -293,7 +295,7 @@ auto inorder_iterator_base_t<Leaf, Branch, IsConst>::operator++() noexcept
   // Else go forward.
   // First case if for non-function nodes.
   if (val_.ptr_->has_parent()) {
-    branch_t &parent = val_.ptr_->get_parent();
+    internal_branch_type &parent = val_.ptr_->get_parent();
     // If node is last child then go to parent and set it to
     // be visited.
     if (&parent.get_lastchild() == val_.ptr_) {
@@ -320,7 +322,7 @@ auto inorder_iterator_base_t<Leaf, Branch, IsConst>::operator--() noexcept
   // Parent is visited. Next is either unvisited parent itself
   // if it is empty, or visited lastchild in other case.
   if (val_.ptr_->is_branch() && val_.visited_) {
-    auto *parent = static_cast<branch_t *>(val_.ptr_);
+    auto *parent = static_cast<internal_branch_type *>(val_.ptr_);
     if (parent->empty())
       val_.visited_ = false;
     else
@@ -329,7 +331,7 @@ auto inorder_iterator_base_t<Leaf, Branch, IsConst>::operator--() noexcept
   }
 
   if (val_.ptr_->has_parent()) {
-    branch_t &parent = val_.ptr_->get_parent();
+    internal_branch_type &parent = val_.ptr_->get_parent();
     // If node is firstchild then go upward and set
     // parent to be unvisited.
     if (val_.ptr_ == &parent.get_firstchild()) {
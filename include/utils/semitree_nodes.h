@@ -132,6 +132,17 @@ public:
   auto get_sibling_iterator() { return sibling_iterator_t{this}; }
   auto get_sibling_iterator() const { return const_sibling_iterator_t{this}; }
 
+  // Whether this node is n itself or lies somewhere in subtree of n.
+  // Linear in depth, intended for debug checks.
+  bool in_subtree_of(const node_t &n) const {
+    for (const node_t *p = this;; p = &p->get_parent()) {
+      if (p == &n)
+        return true;
+      if (!p->has_parent())
+        return false;
+    }
+  }
+
 protected:
   // To be called from branch node.
   void insert(const_sibling_iterator_t it, node_t &n) {
@@ -140,6 +151,38 @@ protected:
     n.insert_between(const_cast<node_t &>(left), const_cast<node_t &>(right));
   }
 
+  // To be called from branch node. Node becomes orphan again.
+  void detach(node_t &n) {
+    n.prev_->next_ = n.next_;
+    n.next_->prev_ = n.prev_;
+    n.parent_ = nullptr;
+    n.prev_ = nullptr;
+    n.next_ = nullptr;
+  }
+
+  // To be called from branch node. Relinks non-empty sibling range
+  // [first, last] before 'it'. Only parent links of range nodes are
+  // touched beside ends, and only if parent changes.
+  void splice(const_sibling_iterator_t it, node_t &first, node_t &last) {
+    node_t &right = const_cast<node_t &>(*it);
+    first.prev_->next_ = last.next_;
+    last.next_->prev_ = first.prev_;
+
+    node_t &left = *right.prev_;
+    left.next_ = &first;
+    first.prev_ = &left;
+    right.prev_ = &last;
+    last.next_ = &right;
+
+    if (first.parent_ == right.parent_)
+      return;
+    for (node_t *p = &first;; p = p->next_) {
+      p->parent_ = right.parent_;
+      if (p == &last)
+        break;
+    }
+  }
+
 private:
   void insert_between(node_t &left, node_t &right) {
     left.next_ = this;
@@ -210,6 +253,62 @@ public:
     return sibling_iterator_t{&n.get_next()};
   }
 
+  // Detach child pointed by 'it' together with its subtree in O(1).
+  // Detached node becomes orphan and can be inserted anywhere again.
+  // Return value: iterator to next sibling.
+  sibling_iterator_t detach(const_sibling_iterator_t it) {
+    check_branch();
+    assert(it != end() && "Cannot detach end of children list");
+    assert(&it->get_parent() == this &&
+           "Can detach only node from this node children list");
+    auto &n = const_cast<node_t &>(*it);
+    sibling_iterator_t next{&n.get_next()};
+    node_t::detach(n);
+    return next;
+  }
+
+  // Move sibling range [first, last) of any branch (this one included)
+  // with their subtrees before 'it'. Subtrees are not walked: this is O(1)
+  // inside one branch and linear in number of moved siblings otherwise
+  // (only their parent links are updated).
+  // Return value: 'it'.
+  sibling_iterator_t splice(const_sibling_iterator_t it,
+                            const_sibling_iterator_t first,
+                            const_sibling_iterator_t last) {
+    check_branch();
+    assert(it->has_parent() && "Cannot use orphan node as inserting point");
+    assert(&it->get_parent() == this &&
+           "Can splice only before iterator from this node children list");
+    auto pos = sibling_iterator_t{const_cast<node_t *>(&*it)};
+    if (first == last || it == last)
+      return pos;
+    assert(&first->get_parent() == &last->get_parent() &&
+           "Spliced range shall be siblings");
+#ifndef NDEBUG
+    for (auto r = first; r != last; ++r) {
+      assert(r != it && "Cannot splice before node from spliced range");
+      assert(!this->in_subtree_of(*r) && "Cannot splice node into itself");
+    }
+#endif
+    auto &f = const_cast<node_t &>(*first);
+    auto &l = const_cast<node_t &>(last->get_prev());
+    node_t::splice(it, f, l);
+    return pos;
+  }
+
+  // Move node with its subtree before 'it' in O(1).
+  // Node may be orphan or child of any branch (this one included).
+  // Return value: 'it'.
+  sibling_iterator_t move(const_sibling_iterator_t it, node_t &n) {
+    check_branch();
+    assert(!this->in_subtree_of(n) && "Cannot move node into itself");
+    if (&*it == &n)
+      return sibling_iterator_t{&n};
+    if (n.has_parent())
+      node_t::detach(n);
+    return insert(it, n);
+  }
+
   node_t &get_firstchild() {
     check_branch();
     return sent_.get_next();
@@ -0,0 +1,91 @@
+//------------------------------------------------------------------------------
+//
+// Definitions for semitree node pool.
+//
+// Semitree is intrusive and leaves node ownership to the user. Node pool is
+// the simplest owner: nodes are constructed in place in fixed-size slabs,
+// never move (so links between them stay valid while pool grows) and are
+// destroyed all together when pool is cleared or destroyed.
+//
+// Nodes are numbered in order of creation, n-th node is two indexing steps
+// away, so number can serve as compact handle for node.
+//
+// node_pool_t<branch> pool;
+// branch &b = pool.create(1);
+// assert(&pool[0] == &b);
+//
+//------------------------------------------------------------------------------
+//
+// This file is licensed after LGPL v3
+// Look at: https://www.gnu.org/licenses/lgpl-3.0.en.html for details
+//
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cassert>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace semitree {
+
+template <typename T, int SlabShift = 8> class node_pool_t {
+  static constexpr int SLAB_SIZE = 1 << SlabShift;
+  static constexpr int SLAB_MASK = SLAB_SIZE - 1;
+
+  // Raw storage for single node.
+  struct slot_t {
+    alignas(T) unsigned char bytes[sizeof(T)];
+  };
+
+  std::vector<std::unique_ptr<slot_t[]>> slabs_;
+  int size_ = 0;
+
+  T *at(int n) const {
+    assert(n >= 0 && n < size_ && "Node pool index out of range");
+    slot_t &s = slabs_[n >> SlabShift][n & SLAB_MASK];
+    return std::launder(reinterpret_cast<T *>(s.bytes));
+  }
+
+public:
+  node_pool_t() = default;
+  node_pool_t(const node_pool_t &) = delete;
+  node_pool_t &operator=(const node_pool_t &) = delete;
+  ~node_pool_t() { clear(); }
+
+  // Construct new node at the end of pool.
+  // Return value: reference to it, valid until pool is cleared.
+  template <typename... Args> T &create(Args &&...args) {
+    if (size_ == int(slabs_.size()) * SLAB_SIZE)
+      slabs_.emplace_back(new slot_t[SLAB_SIZE]);
+    slot_t &s = slabs_[size_ >> SlabShift][size_ & SLAB_MASK];
+    T *p = new (s.bytes) T(std::forward<Args>(args)...);
+    ++size_;
+    return *p;
+  }
+
+  // Destroy all nodes and free slabs in one step.
+  // Nodes are not unlinked, so no tree shall refer to them after this.
+  void clear() {
+    if constexpr (!std::is_trivially_destructible_v<T>)
+      for (int n = 0; n != size_; ++n)
+        at(n)->~T();
+    slabs_.clear();
+    size_ = 0;
+  }
+
+  void reserve(int n) {
+    slabs_.reserve((n + SLAB_SIZE - 1) / SLAB_SIZE);
+  }
+
+  int size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  T &operator[](int n) { return *at(n); }
+  const T &operator[](int n) const { return *at(n); }
+};
+
+} // namespace semitree
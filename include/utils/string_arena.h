@@ -0,0 +1,79 @@
+//------------------------------------------------------------------------------
+//
+// String arena: interned names storage
+//
+// Names (like "T12", "g5" or "foo3") are computed once per stage and then
+// queried many times by dumps and printers. Arena keeps them back to back in
+// single character buffer, n-th string is [offs_[n], offs_[n + 1])
+//
+// string_arena_t names;
+// int n = names.add_numbered("foo", 3);
+// std::cout << names[n]; // prints foo3
+//
+// Views are valid until next add, so arena is filled on construction and
+// then only queried
+//
+//------------------------------------------------------------------------------
+//
+// This file is licensed after LGPL v3
+// Look at: https://www.gnu.org/licenses/lgpl-3.0.en.html for details
+//
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cassert>
+#include <charconv>
+#include <string_view>
+#include <vector>
+
+namespace utils {
+
+class string_arena_t {
+  std::vector<char> buf_;
+  std::vector<int> offs_{0};
+
+public:
+  void reserve(int nstrings, int nchars) {
+    offs_.reserve(nstrings + 1);
+    buf_.reserve(nchars);
+  }
+
+  int size() const { return offs_.size() - 1; }
+
+  std::string_view operator[](int n) const {
+    assert(n >= 0 && n < size());
+    return std::string_view(buf_.data() + offs_[n], offs_[n + 1] - offs_[n]);
+  }
+
+  // appending to last string, i.e. building it in place
+  void append(std::string_view s) {
+    buf_.insert(buf_.end(), s.begin(), s.end());
+  }
+
+  void append(int n) {
+    char digits[16];
+    auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), n);
+    assert(ec == std::errc());
+    buf_.insert(buf_.end(), digits, end);
+  }
+
+  // finish string built by appends, returns its number
+  int seal() {
+    offs_.push_back(buf_.size());
+    return size() - 1;
+  }
+
+  int add(std::string_view s) {
+    append(s);
+    return seal();
+  }
+
+  int add_numbered(std::string_view prefix, int n) {
+    append(prefix);
+    append(n);
+    return seal();
+  }
+};
+
+} // namespace utils
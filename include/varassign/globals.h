@@ -0,0 +1,152 @@
+//------------------------------------------------------------------------------
+//
+// Varassign: global variables layer
+//
+// Global variables are first nglobals variables of every varassign. They do
+// not depend on functions, so several varassign randomizations may share
+// single immutable layer (see VA::SHAREGLOBALS) and store only function own
+// variables on top of it
+//
+// Layer owns not only VA::NGLOBALS primary globals, but also their helpers:
+// pointees, permutators and accessor indexes. Helpers are globals too and
+// follow primary ones, so function accepting primary global gets its
+// helpers with it and nothing global is rebuilt per function
+//
+//------------------------------------------------------------------------------
+//
+// This file is licensed after LGPL v3
+// Look at: https://www.gnu.org/licenses/lgpl-3.0.en.html for details
+//
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include "config/configs.h"
+#include "utils/string_arena.h"
+#include "variable.h"
+
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace tg {
+class typegraph_t;
+}
+
+namespace va {
+
+using acc_cont_t = std::vector<int>;
+using accit_t = typename acc_cont_t::const_iterator;
+using perm_cont_t = std::vector<int>;
+using permit_t = typename perm_cont_t::const_iterator;
+
+// special meaning of variable inside function, bitmask
+enum : unsigned char { VR_PERM = 1, VR_INDEX = 2, VR_ARG = 4 };
+
+// variables and their relations while being created, variable ids are
+// base + index in types. Same for function own variables and globals
+struct staging_t {
+  const cfg::config &cf;
+  const tg::typegraph_t &tg;
+  int base;
+  std::vector<int> types;
+  std::vector<int> vars;
+  std::vector<std::pair<int, unsigned char>> roles;
+  std::vector<std::pair<int, int>> accs;
+  std::vector<std::pair<int, int>> perms;
+  std::vector<std::pair<int, std::pair<int, int>>> pointees;
+
+  staging_t(const cfg::config &c, const tg::typegraph_t &t, int b)
+      : cf(c), tg(t), base(b) {}
+
+  // creates single variable, returns its id
+  int create_var(int tid);
+
+  // creates pointees, permutators and accessor indexes of variable vid
+  // having type tid, all of them are added to vars
+  void process_var(int vid, int tid);
+
+private:
+  void create_pointee(int vid, int tid);
+};
+
+// (slot, value) pairs to CSR preserving order of values inside slot
+template <typename T, typename SlotF>
+void build_csr(int nslots, const std::vector<std::pair<int, T>> &src,
+               SlotF slotf, std::vector<int> &offs, std::vector<T> &vals) {
+  offs.assign(nslots + 1, 0);
+  for (auto &p : src)
+    offs[slotf(p.first) + 1] += 1;
+  for (int s = 0; s < nslots; ++s)
+    offs[s + 1] += offs[s];
+  vals.resize(src.size());
+  std::vector<int> fill(offs.begin(), offs.end() - 1);
+  for (auto &p : src)
+    vals[fill[slotf(p.first)]++] = p.second;
+}
+
+class globals_t final {
+  // global variables gx, variable id is index here
+  // primary globals are [0 .. nprimary_), helpers follow
+  std::vector<variable_t> vars_;
+  utils::string_arena_t names_;
+  int nprimary_ = 0;
+
+  // helpers of primary global g are helpers_[helper_offs_[g] .. +1)
+  std::vector<int> helper_offs_;
+  std::vector<int> helpers_;
+
+  // roles and relations of every global, same layout as function ones
+  // (see varassign_t::func_vars)
+  std::vector<unsigned char> roles_;
+  std::vector<int> acc_offs_;
+  std::vector<int> accs_;
+  std::vector<int> perm_offs_;
+  std::vector<int> perms_;
+  std::vector<int> pointee_offs_;
+  std::vector<std::pair<int, int>> pointees_;
+
+public:
+  // takes VA::NGLOBALS and random types from given config
+  globals_t(const cfg::config &, const tg::typegraph_t &);
+
+  int size() const { return vars_.size(); }
+  int nprimary() const { return nprimary_; }
+  variable_t at(int vid) const { return vars_[vid]; }
+  std::string_view get_name(int vid) const { return names_[vid]; }
+
+  auto helpers_begin(int vid) const {
+    return helpers_.cbegin() + helper_offs_[vid];
+  }
+  auto helpers_end(int vid) const {
+    return helpers_.cbegin() + helper_offs_[vid + 1];
+  }
+
+  bool has_role(int vid, unsigned char role) const {
+    return roles_[vid] & role;
+  }
+
+  accit_t accs_begin(int vid) const {
+    return accs_.cbegin() + acc_offs_[vid];
+  }
+  accit_t accs_end(int vid) const {
+    return accs_.cbegin() + acc_offs_[vid + 1];
+  }
+
+  permit_t perms_begin(int vid) const {
+    return perms_.cbegin() + perm_offs_[vid];
+  }
+  permit_t perms_end(int vid) const {
+    return perms_.cbegin() + perm_offs_[vid + 1];
+  }
+
+  // later pairs override earlier ones, -1 if no pointee
+  int find_pointee(int vid, int tid) const {
+    for (int i = pointee_offs_[vid + 1]; i != pointee_offs_[vid]; --i)
+      if (pointees_[i - 1].first == tid)
+        return pointees_[i - 1].second;
+    return -1;
+  }
+};
+
+} // namespace va
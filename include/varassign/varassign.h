@@ -27,6 +27,13 @@
 // Example: in function 5, variable 15 have type A5 (array of int)
 //          special meaning PERM and name p3 inside function
 //
+// Storage: globals have ids [0, nglobals) and live in separate immutable
+// layer together with their roles and mappings, which may be shared by
+// several varassigns (VA::SHAREGLOBALS). Every function own variables are
+// created together, so they have ids [lo, lo + nown). Function slot of own
+// variable is id - lo, per-slot roles are dense bytes, per-slot mappings
+// are CSR arrays. Questions about globals go to globals layer
+//
 //------------------------------------------------------------------------------
 //
 // This file is licensed after LGPL v3
@@ -37,11 +44,14 @@
 #pragma once
 
 #include "config/configs.h"
+#include "globals.h"
+#include "utils/string_arena.h"
 #include "variable.h"
 
+#include <cassert>
 #include <memory>
-#include <unordered_map>
-#include <unordered_set>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 namespace tg {
@@ -54,125 +64,162 @@ class callgraph_t;
 
 namespace va {
 
-using acc_cont_t = std::vector<int>;
-using accit_t = typename acc_cont_t::const_iterator;
-using perm_cont_t = std::vector<int>;
-using permit_t = typename perm_cont_t::const_iterator;
-
 class varassign_t final {
   cfg::config config_;
   std::shared_ptr<tg::typegraph_t> tgraph_;
   std::shared_ptr<cg::callgraph_t> cgraph_;
 
-  // storage for variables vx
-  std::vector<variable_t> vars_;
+  // global variables gx are [0 .. nglobals_), possibly shared layer
+  std::shared_ptr<const globals_t> globals_;
+  int nglobals_ = 0;
 
-  // global variables gx
-  std::unordered_set<int> globals_;
+  // storage for function own variables vx, vars_[n] has id nglobals_ + n
+  std::vector<variable_t> vars_;
 
   struct func_vars {
-    // function vars
-    std::vector<int> vars_;
-
-    // permutators px
-    std::unordered_set<int> perms_;
+    // first and past-the-end own variable
+    int lo_ = 0;
+    int hi_ = 0;
 
-    // indexes ix
-    std::unordered_set<int> indexes_;
+    // function vars, own and accepted globals with their helpers
+    std::vector<int> vars_;
 
-    // arguments xx
-    std::unordered_set<int> args_;
-
-    // pointees: x -> y -> z
-    // If v[x] have pointer subtypes, they point to some v[z]
-    // Namely, pts[x] gives map of subtypes to pointee variables
-    std::unordered_map<int, std::unordered_map<int, int>> pointees_;
+    // roles of every own slot: permutators px, indexes ix, arguments xx
+    std::vector<unsigned char> roles_;
 
     // accessor idxs
     // array or struct with array members vx may have accessors iy, iz, ....
-    std::unordered_map<int, acc_cont_t> accidxs_;
+    // for slot s they are accs_[acc_offs_[s] .. acc_offs_[s + 1])
+    std::vector<int> acc_offs_;
+    std::vector<int> accs_;
 
     // permutator idxs
     // array vx[iz] may have permutator py[iz] (also array) like this:
     // vx[py[iz]] we may have a lot of stacked permutators vx[pa[pb[pc[iz]]]]
-    std::unordered_map<int, perm_cont_t> permutators_;
-
-    void register_index(int iid) {
-      indexes_.insert(iid);
-      vars_.push_back(iid);
-    }
-
-    bool is_perm(int vid) const { return perms_.find(vid) != perms_.end(); }
-    bool is_index(int vid) const {
-      return indexes_.find(vid) != indexes_.end();
-    }
-    bool is_argument(int vid) const { return args_.find(vid) != args_.end(); }
-  };
+    std::vector<int> perm_offs_;
+    std::vector<int> perms_;
 
-  bool is_global(int vid) const { return globals_.find(vid) != globals_.end(); }
+    // pointees: x -> y -> z
+    // If v[x] have pointer subtypes y, they point to some v[z]
+    // for slot s (y, z) pairs are pointees_[pointee_offs_[s] .. +1])
+    std::vector<int> pointee_offs_;
+    std::vector<std::pair<int, int>> pointees_;
+  };
 
   // every function have some variables
   std::vector<func_vars> fvars_;
 
+  // interned names of function own variables, indexed as vars_
+  utils::string_arena_t names_;
+
+  // slot of own variable inside function or -1 if function do not own it
+  int slot(int nfunc, int vid) const {
+    auto &fv = fvars_[nfunc];
+    if (vid < fv.lo_ || vid >= fv.hi_)
+      return -1;
+    return vid - fv.lo_;
+  }
+
+  bool has_role(int nfunc, int vid, unsigned char role) const {
+    if (is_global(vid))
+      return globals_->has_role(vid, role);
+    int s = slot(nfunc, vid);
+    return (s != -1) && (fvars_[nfunc].roles_[s] & role);
+  }
+
   // public interface
 public:
+  // globals layer may be nullptr, then varassign creates its own
   explicit varassign_t(cfg::config &&, std::shared_ptr<tg::typegraph_t>,
-                       std::shared_ptr<cg::callgraph_t>);
+                       std::shared_ptr<cg::callgraph_t>,
+                       std::shared_ptr<const globals_t> = nullptr);
 
-  // iterators for all vars
+  // all vars are [0 .. nvars())
   // value type is variable_t i.e. variable + type
-  auto begin() const { return vars_.cbegin(); }
-  auto end() const { return vars_.cend(); }
+  int nvars() const { return nglobals_ + vars_.size(); }
 
-  variable_t at(int n) const { return vars_[n]; }
+  bool is_global(int vid) const { return vid < nglobals_; }
+
+  variable_t at(int n) const {
+    return is_global(n) ? globals_->at(n) : vars_[n - nglobals_];
+  }
 
   // iterators for specific function vars (useful for controlgraph split)
   // value type is int, i.e. index in all vars
   auto fv_begin(int nfunc) const { return fvars_[nfunc].vars_.cbegin(); }
   auto fv_end(int nfunc) const { return fvars_[nfunc].vars_.cend(); }
 
+  bool is_perm(int nfunc, int vid) const {
+    return has_role(nfunc, vid, VR_PERM);
+  }
+
+  bool is_index(int nfunc, int vid) const {
+    return has_role(nfunc, vid, VR_INDEX);
+  }
+
+  bool is_argument(int nfunc, int vid) const {
+    return has_role(nfunc, vid, VR_ARG);
+  }
+
+  // later pairs override earlier ones, so search is backwards
   bool have_pointee(int nfunc, int vid, int tid) const {
-    auto &ps = fvars_[nfunc].pointees_;
-    auto pcit = ps.find(vid);
-    if (pcit == ps.end())
-      return false;
-    return pcit->second.find(tid) != pcit->second.end();
+    return find_pointee(nfunc, vid, tid) != -1;
   }
 
   int pointee(int nfunc, int vid, int tid) const {
     assert(have_pointee(nfunc, vid, tid) &&
            "No pointee for this variable subtype");
-    return fvars_[nfunc].pointees_.at(vid).at(tid);
+    return find_pointee(nfunc, vid, tid);
   }
 
   bool have_accs(int nfunc, int vid) const {
-    auto &accs = fvars_[nfunc].accidxs_;
-    auto accit = accs.find(vid);
-    if (accit == accs.end())
-      return false;
-    return !accit->second.empty();
+    return accs_begin(nfunc, vid) != accs_end(nfunc, vid);
   }
 
   accit_t accs_begin(int nfunc, int vid) const {
-    auto accit = fvars_[nfunc].accidxs_.find(vid);
-    return accit->second.cbegin();
+    if (is_global(vid))
+      return globals_->accs_begin(vid);
+    auto &fv = fvars_[nfunc];
+    int s = slot(nfunc, vid);
+    return fv.accs_.cbegin() + (s == -1 ? 0 : fv.acc_offs_[s]);
   }
 
   accit_t accs_end(int nfunc, int vid) const {
-    auto accit = fvars_[nfunc].accidxs_.find(vid);
-    return accit->second.cend();
+    if (is_global(vid))
+      return globals_->accs_end(vid);
+    auto &fv = fvars_[nfunc];
+    int s = slot(nfunc, vid);
+    return fv.accs_.cbegin() + (s == -1 ? 0 : fv.acc_offs_[s + 1]);
+  }
+
+  permit_t perms_begin(int nfunc, int vid) const {
+    if (is_global(vid))
+      return globals_->perms_begin(vid);
+    auto &fv = fvars_[nfunc];
+    int s = slot(nfunc, vid);
+    return fv.perms_.cbegin() + (s == -1 ? 0 : fv.perm_offs_[s]);
   }
 
-  std::string get_name(int vid, int funcid) const;
+  permit_t perms_end(int nfunc, int vid) const {
+    if (is_global(vid))
+      return globals_->perms_end(vid);
+    auto &fv = fvars_[nfunc];
+    int s = slot(nfunc, vid);
+    return fv.perms_.cbegin() + (s == -1 ? 0 : fv.perm_offs_[s + 1]);
+  }
+
+  // name like p5, unique for all functions
+  std::string_view get_name(int vid) const {
+    return is_global(vid) ? globals_->get_name(vid) : names_[vid - nglobals_];
+  }
 
   void dump(std::ostream &os) const;
 
   // helpers
 private:
-  int create_var(int tid);
-  void create_pointee(int vid, int tid, func_vars &fv);
-  void process_var(int vid, int funcid);
-  void create_function_vars(int fid);
+  int find_pointee(int nfunc, int vid, int tid) const;
+  std::vector<int> create_function_vars(int fid, const cfg::config &cf);
+  void intern_names();
 };
 
 } // namespace va
\ No newline at end of file
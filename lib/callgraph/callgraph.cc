@@ -5,10 +5,12 @@
 // ctor sequence is:
 // 1. generate random graph
 // 2. add more leafs to non-leaf nodes
-// 3. connect components (to remove unreachable nodes)
+// 3. connect components (every function is reachable from main)
+//    and limit longest call path to CG::MAXPATH
 // 4. set self-loops
 // 5. create indirect sets
-// 6. assign function and return types
+//    then adjacency is frozen and reachability index is built
+// 6. assign function and return types (then names are interned)
 // 7. modules affinity
 //
 // assignment of types to functions rules:
@@ -28,46 +30,31 @@
 //------------------------------------------------------------------------------
 
 #include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <iterator>
-#include <map>
+#include <limits>
 #include <memory>
+#include <numeric>
 #include <queue>
+#include <random>
 #include <set>
 
 #include <boost/graph/breadth_first_search.hpp>
 #include <boost/graph/graphviz.hpp>
+#include <boost/graph/strong_components.hpp>
 #include <boost/pending/disjoint_sets.hpp>
-#include <boost/range/adaptor/map.hpp>
-#include <boost/range/algorithm/copy.hpp>
+#include <boost/pending/queue.hpp>
 
 #include "callgraph.h"
 #include "calliters.h"
+#include "coelacanth/tasksystem.h"
 #include "funcmeta.h"
 #include "typegraph/typean.h"
 #include "typegraph/typegraph.h"
 
 namespace cg {
 
-// label for dot dump of callgraph
-std::string
-vertexprop_t::get_name(std::shared_ptr<tg::typegraph_t> tgraph) const {
-  std::ostringstream s;
-  if (rettype == -1)
-    s << "void";
-  else
-    s << tgraph->vertex_from(rettype).get_short_name();
-
-  s << " foo" << funcid << "(";
-  for (auto ait = argtypes.begin(); ait != argtypes.end(); ++ait) {
-    if (ait != argtypes.begin())
-      s << ", ";
-    s << tgraph->vertex_from(*ait).get_short_name();
-  }
-  s << ")";
-  return s.str();
-}
-
 std::string vertexprop_t::get_color() const {
   if (indset != 0)
     return "blue";
@@ -82,16 +69,6 @@ std::string edgeprop_t::get_color() const {
   return "black";
 }
 
-vertexprop_t vertex_from(const callgraph_t *pcg, vertex_t v) {
-  return pcg->vertex_from(v);
-}
-
-vertex_t dest_from(const callgraph_t *pcg, edge_t e) {
-  return pcg->dest_from(e);
-}
-
-vertex_t src_from(const callgraph_t *pcg, edge_t e) { return pcg->src_from(e); }
-
 //------------------------------------------------------------------------------
 //
 // Edge visitor to create spanning tree
@@ -112,18 +89,34 @@ struct bfs_edge_visitor : public boost::default_bfs_visitor {
 //
 //------------------------------------------------------------------------------
 
-template <>
-nbr_iterator_t<outedge_iter_t>::value_type
-nbr_iterator_t<outedge_iter_t>::operator*() const {
-  auto v = dest_from(cgp_, *ei_);
-  return v;
-}
+// iterator over neighbours of v under mask
+// offs and nbrs are frozen adjacency, see callgraph_t
+static nbr_iterator_t nbr_iterator(const std::vector<int> &offs,
+                                   const std::vector<vertex_t> &nbrs,
+                                   vertex_t v, calltype_t mask, bool at_end) {
+  unsigned m = static_cast<unsigned>(mask) & ((1u << NCALLTYPES) - 1);
+  const int *voffs = offs.data() + v * NCALLTYPES;
+  if (m == 0)
+    return nbr_iterator_t(nbrs.data() + voffs[0], 0, 0, 0);
+
+  int lo = 0, hi = NCALLTYPES - 1;
+  while (!(m & (1u << lo)))
+    lo += 1;
+  while (!(m & (1u << hi)))
+    hi -= 1;
+
+  // [lo, hi] have at most one hole in the middle
+  int first = voffs[hi + 1] - voffs[lo];
+  int gap = 0;
+  for (int k = lo + 1; k < hi; ++k)
+    if (!(m & (1u << k))) {
+      first = voffs[k] - voffs[lo];
+      gap = voffs[k + 1] - voffs[k];
+    }
 
-template <>
-nbr_iterator_t<inedge_iter_t>::value_type
-nbr_iterator_t<inedge_iter_t>::operator*() const {
-  auto v = src_from(cgp_, *ei_);
-  return v;
+  int total = voffs[hi + 1] - voffs[lo] - gap;
+  return nbr_iterator_t(nbrs.data() + voffs[lo], first, gap,
+                        at_end ? total : 0);
 }
 
 //------------------------------------------------------------------------------
@@ -150,6 +143,9 @@ callgraph_t::callgraph_t(cfg::config &&cf,
   // connecting components
   connect_components();
 
+  // limiting call depth
+  limit_paths();
+
   // adding possible self-loops
   // We can not do it earlier, self-loops will break in-degree analysis
   // in components connection function
@@ -160,12 +156,27 @@ callgraph_t::callgraph_t(cfg::config &&cf,
   // create indirect calls set
   create_indcalls();
 
+  // partition callees and callers by calltype
+  freeze_adjacency();
+
+  // SCCs and transitive callees
+  build_reachability();
+
+  // indirect calls, which never close cycles
+  rank_indirect();
+
   // decide on high-level metastructure
   decide_metastructure();
 
+  // type acceptance for all metastructure classes
+  build_accept_tables();
+
   // assign function and return types
   assign_types();
 
+  // function names and signatures
+  intern_names();
+
   // modules affinity
   map_modules();
 }
@@ -182,24 +193,33 @@ vertex_iter_t callgraph_t::end() const {
 
 callee_iterator_t callgraph_t::callees_begin(vertex_t v,
                                              calltype_t mask) const {
-  auto [ei, ei_end] = boost::out_edges(v, graph_);
-  return callee_iterator_t(this, ei, mask);
+  return nbr_iterator(callee_offs_, callees_, v, mask, false);
 }
 
 callee_iterator_t callgraph_t::callees_end(vertex_t v, calltype_t mask) const {
-  auto [ei, ei_end] = boost::out_edges(v, graph_);
-  return callee_iterator_t(this, ei_end, mask);
+  return nbr_iterator(callee_offs_, callees_, v, mask, true);
 }
 
 caller_iterator_t callgraph_t::callers_begin(vertex_t v,
                                              calltype_t mask) const {
-  auto [ei, ei_end] = boost::in_edges(v, graph_);
-  return caller_iterator_t(this, ei, mask);
+  return nbr_iterator(caller_offs_, callers_, v, mask, false);
 }
 
 caller_iterator_t callgraph_t::callers_end(vertex_t v, calltype_t mask) const {
-  auto [ei, ei_end] = boost::in_edges(v, graph_);
-  return caller_iterator_t(this, ei_end, mask);
+  return nbr_iterator(caller_offs_, callers_, v, mask, true);
+}
+
+// same SCC means cycle, if any, otherwise look up reachability window of f
+// (see build_reachability)
+bool callgraph_t::may_reach(vertex_t f, vertex_t g) const {
+  int cf = scc_[f];
+  int cg = scc_[g];
+  if (cf == cg)
+    return recursive_[cf];
+  int w = cg / 64 - reach_lo_[cf];
+  if (w < 0 || w >= reach_offs_[cf + 1] - reach_offs_[cf])
+    return false;
+  return (reach_bits_[reach_offs_[cf] + w] >> (cg % 64)) & 1;
 }
 
 // dump as dot file
@@ -208,13 +228,15 @@ void callgraph_t::dump(std::ostream &os) const {
   auto vbundle = boost::get(boost::vertex_bundle, graph_);
   dp.property("node_id", boost::get(boost::vertex_index, graph_));
 
-  // std::mem_fn(&vertexprop_t::get_name)
-  auto cg_name = [this](vertexprop_t v) { return v.get_name(tgraph_); };
+  auto cg_name = [this](vertexprop_t v) { return signature(v.funcid); };
 
   dp.property("label",
               boost::make_transform_value_property_map(cg_name, vbundle));
   dp.property("color", boost::make_transform_value_property_map(
                            std::mem_fn(&vertexprop_t::get_color), vbundle));
+  auto cg_module = [](vertexprop_t v) { return v.moduleno; };
+  dp.property("module",
+              boost::make_transform_value_property_map(cg_module, vbundle));
 
   auto ebundle = boost::get(boost::edge_bundle, graph_);
   dp.property("style", boost::make_transform_value_property_map(
@@ -225,62 +247,106 @@ void callgraph_t::dump(std::ostream &os) const {
   boost::write_graphviz_dp(os, graph_, dp);
 }
 
-bool callgraph_t::accept_type(vertex_t v, tg::vertex_t vt) const {
-  ms::metanode_t m = graph_[v].metainfo;
-  tg::vertexprop_t vpt = tgraph_->vertex_from(vt);
-  return accept_type(m, vpt);
-}
-
 //------------------------------------------------------------------------------
 //
 // Callgraph construction helpers
 //
 //------------------------------------------------------------------------------
 
+// adjacency rows generated by single task in generate_random_graph
+// fixed, so result do not depend on number of consumers
+constexpr int ROWS_PER_BLOCK = 256;
+
+// Every ordered pair (u, v), u != v gets an edge with probability p, but
+// instead of tossing a coin for each of V * (V - 1) pairs we draw geometric
+// gaps between consecutive successes (Batagelj & Brandes, 2005)
+// so amount of random draws is O(V + E)
+//
+// this function samples rows [rfrom, rto) with its own rng stream
+static void sample_rows(int rfrom, int rto, int nvertices, double p, int seed,
+                        std::vector<std::pair<vertex_t, vertex_t>> &edges) {
+  using pos_t = long long;
+  pos_t nrow = nvertices - 1;
+  pos_t first = rfrom * nrow;
+  pos_t npairs = rto * nrow;
+
+  double expected = p * (npairs - first);
+  edges.reserve(static_cast<size_t>(expected + 3 * std::sqrt(expected) + 1));
+
+  // pair position pos maps to row pos / nrow, self-loop slot is skipped
+  auto add_pair = [&edges, nrow](pos_t pos) {
+    pos_t u = pos / nrow, v = pos % nrow;
+    if (v >= u)
+      v += 1;
+    edges.emplace_back(u, v);
+  };
+
+  if (p >= 1.0) {
+    for (pos_t pos = first; pos < npairs; ++pos)
+      add_pair(pos);
+    return;
+  }
+
+  if (p <= 0.0)
+    return;
+
+  std::mt19937_64 rng(seed);
+  double logq = std::log1p(-p);
+  for (pos_t pos = first - 1;;) {
+    // r is uniform in (0, 1], so log(r) is finite
+    double r = ((rng() >> 11) + 1) * 0x1.0p-53;
+    double skip = std::floor(std::log(r) / logq);
+    if (skip >= double(npairs - pos - 1))
+      break;
+    pos += 1 + static_cast<pos_t>(skip);
+    add_pair(pos);
+  }
+}
+
 // I tried boost::generate_random_graph
 // I also tried boost::erdos_renyi_iterator
 // none served well enough, so fall back to custom method
+//
+// Rows are split in blocks of ROWS_PER_BLOCK, each block is separate task with
+// rng stream derived from callgraph seed and block number, then blocks are
+// concatenated in order. So graph is the same for given seed whatever number
+// of threads do the work
 void callgraph_t::generate_random_graph(int nvertices) {
-  for (int i = 0; i < nvertices; ++i) {
-    auto v = boost::add_vertex(graph_);
-    graph_[v].funcid = v;
-  }
+  double p = cfg::pflag_prob(config_, CG::EDGESET);
+  int seed = config_.rand_positive();
+  int nblocks = (nvertices + ROWS_PER_BLOCK - 1) / ROWS_PER_BLOCK;
+  std::vector<std::vector<std::pair<vertex_t, vertex_t>>> blocks(nblocks);
+
+  auto sample_block = [&](int nblock) {
+    int rfrom = nblock * ROWS_PER_BLOCK;
+    int rto = std::min(rfrom + ROWS_PER_BLOCK, nvertices);
+    sample_rows(rfrom, rto, nvertices, p, cfg::derive_seed(seed, nblock),
+                blocks[nblock]);
+  };
 
-  // TODO:
-  // To make call graph more interesting we may want to generate strongly
-  // coupled internally components, loosely coupled pairwise
-  // We may think about some option, like CG::LOOSE_COMPONENTS (0/1)
+  if (nblocks > 1)
+    parallel_for(nblocks, sample_block);
+  else if (nblocks == 1)
+    sample_block(0);
 
-  // we do not want to allow self-loops on this stage
-  for (auto [vi, vi_end] = boost::vertices(graph_); vi != vi_end; ++vi)
-    for (auto [vi2, vi2_end] = boost::vertices(graph_); vi2 != vi2_end; ++vi2)
-      if ((vi != vi2) && cfg::get(config_, CG::EDGESET))
-        boost::add_edge(*vi, *vi2, graph_);
+  size_t nedges = 0;
+  for (auto &b : blocks)
+    nedges += b.size();
 
-  // TODO:
-  // To make graph more realistic it makes sense to create option to control
-  // max length of the longest path in the graph (like CG::MAXPATH)
-  // Say we can prune long paths by inverting edges in-between
+  std::vector<std::pair<vertex_t, vertex_t>> edges;
+  edges.reserve(nedges);
+  for (auto &b : blocks)
+    edges.insert(edges.end(), b.begin(), b.end());
 
-  int nheads = 0;
+  // we do not want to allow self-loops on this stage (and we have none)
+  graph_ = cgraph_t(edges.begin(), edges.end(), nvertices);
   for (auto [vi, vi_end] = boost::vertices(graph_); vi != vi_end; ++vi)
-    if (vertex_t v = *vi; boost::in_degree(v, graph_) == 0)
-      nheads += 1;
-
-  // highly unprobable case: no vertex have zero in-degree
-  if (0 == nheads) {
-    std::vector<vertex_t> conns;
-    cfg::config_rng cfrng(config_);
-    auto [vi, vi_end] = boost::vertices(graph_);
-    int nconns = cfg::get(config_, CG::ARTIFICIAL_CONNS);
-    std::sample(vi, vi_end, std::back_inserter(conns), nconns,
-                std::move(cfrng));
-
-    auto v = boost::add_vertex(graph_);
-    graph_[v].funcid = v;
-    for (auto vc : conns)
-      boost::add_edge(v, vc, graph_);
-  }
+    graph_[*vi].funcid = *vi;
+
+  // TODO:
+  // To make call graph more interesting we may want to generate strongly
+  // coupled internally components, loosely coupled pairwise
+  // We may think about some option, like CG::LOOSE_COMPONENTS (0/1)
 }
 
 void callgraph_t::process_leafs() {
@@ -306,25 +372,48 @@ void callgraph_t::process_leafs() {
   }
 }
 
-// TODO:
-// component connection is not ideal
-// consider graph like {A, B, C, D, B->C, C->D, D->B}
-// it will find only {A} and set A to be main, leaving {B, C, D} dead code
-// but it is already overly complicated and in most cases it works
-// so let it be
+// Component connection
+// 1. condense graph to DAG of strongly connected components (Tarjan)
+//    every source SCC (no edges from other SCCs) gives head: its least vertex
+//    now every vertex is reachable from some head, head-less cycles like
+//    {B->C, C->D, D->B} included
+// 2. split graph to weakly connected components (union-find)
+// 3. first head of every component calls other its heads
+// 4. largest component goes first, its head is main
+//    main calls first head of every other component, this edge becomes
+//    direct call (see add_self_loops), so everything is reachable from main
+//    those heads, which fit into indirect set, may also be called indirectly
+//    (see create_indcalls), others are merged into main component
+// Everything is O(V + E) modulo inverse Ackermann
 void callgraph_t::connect_components() {
-  auto n = boost::num_vertices(graph_);
-  std::vector<int> rank_map(n);
-  std::vector<vertex_t> pred_map(n);
-
-  auto rank = make_iterator_property_map(
-      rank_map.begin(), boost::get(boost::vertex_index, graph_), rank_map[0]);
-  auto parent = make_iterator_property_map(
-      pred_map.begin(), boost::get(boost::vertex_index, graph_), pred_map[0]);
+  int nv = boost::num_vertices(graph_);
+  auto vindex = boost::get(boost::vertex_index, graph_);
+
+  std::vector<int> scc(nv);
+  int nscc = boost::strong_components(
+      graph_, boost::make_iterator_property_map(scc.begin(), vindex));
+
+  std::vector<int> sccrep(nscc, -1);
+  for (int v = 0; v < nv; ++v)
+    if (sccrep[scc[v]] == -1)
+      sccrep[scc[v]] = v;
+
+  std::vector<char> scc_source(nscc, 1);
+  for (auto [ei, ei_end] = boost::edges(graph_); ei != ei_end; ++ei) {
+    int su = scc[boost::source(*ei, graph_)];
+    int sv = scc[boost::target(*ei, graph_)];
+    if (su != sv)
+      scc_source[sv] = 0;
+  }
+
+  std::vector<int> rank_map(nv);
+  std::vector<vertex_t> pred_map(nv);
+  auto rank = make_iterator_property_map(rank_map.begin(), vindex);
+  auto parent = make_iterator_property_map(pred_map.begin(), vindex);
   boost::disjoint_sets dset(rank, parent);
 
-  for (auto [vi, vi_end] = boost::vertices(graph_); vi != vi_end; ++vi)
-    dset.make_set(*vi);
+  for (int v = 0; v < nv; ++v)
+    dset.make_set(v);
 
   for (auto [ei, eiend] = boost::edges(graph_); ei != eiend; ++ei) {
     edge_t e = *ei;
@@ -337,54 +426,67 @@ void callgraph_t::connect_components() {
   auto [vi, vi_end] = boost::vertices(graph_);
   dset.compress_sets(vi, vi_end);
 
-  std::map<vertex_t, std::vector<vertex_t>> heads;
-  std::vector<vertex_t> hreps_vector;
-
-  for (auto [vi, vi_end] = boost::vertices(graph_); vi != vi_end; ++vi)
-    if (vertex_t v = *vi; boost::in_degree(v, graph_) == 0)
-      heads[dset.find_set(v)].push_back(v);
+  // component number for every vertex and component heads
+  std::vector<int> compno(nv, -1);
+  std::vector<std::vector<vertex_t>> heads;
+  for (int v = 0; v < nv; ++v) {
+    int rep = dset.find_set(v);
+    if (compno[rep] == -1) {
+      compno[rep] = heads.size();
+      heads.emplace_back();
+    }
+    compno[v] = compno[rep];
+    if (sccrep[scc[v]] == v && scc_source[scc[v]])
+      heads[compno[v]].push_back(v);
+  }
 
-  // heads can not be empty by construction
+  // heads can not be empty by construction: condensation is DAG
   assert(!heads.empty());
 
-  // store keys to representatives vector
-  boost::copy(heads | boost::adaptors::map_keys,
-              std::back_inserter(hreps_vector));
-
-  // sort representatives vector by component size backwards
-  std::sort(hreps_vector.begin(), hreps_vector.end(),
-            [heads](vertex_t u, vertex_t v) {
-              return heads.find(u)->second.size() >
-                     heads.find(v)->second.size();
-            });
-
-  // edges from component head to other heads
-  for (auto rep : hreps_vector) {
-    auto &&hvec = heads[rep];
+  // order components by size backwards
+  int ncomps = heads.size();
+  std::vector<int> compsize(ncomps);
+  for (int v = 0; v < nv; ++v)
+    compsize[compno[v]] += 1;
+
+  std::vector<int> order(ncomps);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&compsize](int c1, int c2) {
+    return compsize[c1] > compsize[c2];
+  });
+
+  // main component and no more than nindirect_ components to be called
+  // also indirectly, all others are merged into main component
+  nindirect_ = cfg::get(config_, CG::INDSETCNT);
+  int nkept = std::min(ncomps, nindirect_ + 1);
+  vertex_t main_head = heads[order[0]][0];
+  std::vector<int> newno(ncomps, 0);
+  comps_.assign(nkept, {});
+
+  for (int i = 0; i < ncomps; ++i) {
+    auto &hvec = heads[order[i]];
     vertex_t vtop = hvec[0];
-    for (auto h : hvec) {
-      if (h == vtop)
-        continue;
-      boost::add_edge(vtop, h, graph_);
+    for (auto h : hvec)
+      if (h != vtop)
+        boost::add_edge(vtop, h, graph_);
+
+    if (i > 0)
+      boost::add_edge(main_head, vtop, graph_);
+    if (i < nkept) {
+      newno[order[i]] = i;
+      comps_[i].push_back(vtop);
     }
-
-    // setting component heads
-    comps_.push_back({});
-    size_t ncomp = comps_.size() - 1;
-    comps_[ncomp].push_back(vtop);
-    graph_[vtop].componentno = ncomp;
   }
 
   // distributing functions over components
-  for (auto [vi, vi_end] = boost::vertices(graph_); vi != vi_end; ++vi)
-    for (auto &comp : comps_)
-      if (vertex_t v = *vi;
-          (v != comp[0]) && (dset.find_set(v) == dset.find_set(comp[0]))) {
-        comp.push_back(v);
-        graph_[v].componentno = std::distance(&comps_[0], &comp);
-      }
+  for (int v = 0; v < nv; ++v) {
+    int ncomp = newno[compno[v]];
+    graph_[v].componentno = ncomp;
+    if (comps_[ncomp][0] != vertex_t(v))
+      comps_[ncomp].push_back(v);
+  }
 
-      // main function is now comps_[0][0]
+  // main function is now comps_[0][0]
 #if 0
   std::cout << "Connected components:" << std::endl;
   for (const auto &c : comps_) {
@@ -395,29 +497,153 @@ void callgraph_t::connect_components() {
 #endif
 }
 
-void callgraph_t::add_self_loops() {
-  int main_head = comps_[0][0];
+// Longest path limitation
+// longest path over condensation DAG is computed first: if it fits, nothing
+// to do. Otherwise every SCC gets level: its BFS depth from component heads,
+// capped at MAXPATH. Then for every edge between SCCs:
+// - edge going to deeper level is kept
+// - edge going to shallower level is inverted
+// - edge inside same level is removed
+// Now every path goes strictly down and can not be longer than MAXPATH.
+// BFS tree edges go down unless both ends are capped, so only SCCs deeper
+// than MAXPATH may lose all incoming edges: they are called from their
+// ancestor on level MAXPATH - 1 to keep them reachable from main
+// Indirect calls are not bounded: they are chosen later, per call site (see
+// controlgraph random_callee), so path through them may exceed MAXPATH
+void callgraph_t::limit_paths() {
+  int maxpath = cfg::get(config_, CG::MAXPATH);
+  if (maxpath <= 0)
+    return;
+
+  int nv = nfuncs();
+  auto vindex = boost::get(boost::vertex_index, graph_);
+  std::vector<int> scc(nv);
+  int nscc = boost::strong_components(
+      graph_, boost::make_iterator_property_map(scc.begin(), vindex));
+
+  // Tarjan numbering is reverse topological, make it topological
+  for (auto &c : scc)
+    c = nscc - 1 - c;
+
+  std::vector<int> sccrep(nscc, -1);
+  for (int v = 0; v < nv; ++v)
+    if (sccrep[scc[v]] == -1)
+      sccrep[scc[v]] = v;
+
+  std::vector<std::vector<int>> succs(nscc);
+  for (auto [ei, ei_end] = boost::edges(graph_); ei != ei_end; ++ei) {
+    int su = scc[boost::source(*ei, graph_)];
+    int sv = scc[boost::target(*ei, graph_)];
+    if (su != sv)
+      succs[su].push_back(sv);
+  }
+
+  std::vector<int> longest(nscc, 0);
+  int maxlongest = 0;
+  for (int c = 0; c < nscc; ++c)
+    for (int d : succs[c]) {
+      longest[d] = std::max(longest[d], longest[c] + 1);
+      maxlongest = std::max(maxlongest, longest[d]);
+    }
 
+  if (maxlongest <= maxpath)
+    return;
+
+  // BFS over condensation from main, anchor is ancestor on level
+  // maxpath - 1
+  std::vector<int> depth(nscc, -1);
+  std::vector<int> anchor(nscc, -1);
+  std::vector<int> bfsq;
+  bfsq.reserve(nscc);
+  depth[scc[main_func()]] = 0;
+  bfsq.push_back(scc[main_func()]);
+
+  for (size_t qidx = 0; qidx < bfsq.size(); ++qidx) {
+    int c = bfsq[qidx];
+    if (depth[c] == maxpath - 1)
+      anchor[c] = c;
+    for (int d : succs[c])
+      if (depth[d] == -1) {
+        depth[d] = depth[c] + 1;
+        anchor[d] = anchor[c];
+        bfsq.push_back(d);
+      }
+  }
+
+  assert(int(bfsq.size()) == nscc && "Unreachable functions");
+
+  // parallel edges are possible, so removed are descriptors, not pairs
+  std::vector<edge_t> removed;
+  std::vector<std::pair<vertex_t, vertex_t>> added;
+  std::vector<char> reached(nscc, 0);
+  for (auto [ei, ei_end] = boost::edges(graph_); ei != ei_end; ++ei) {
+    vertex_t u = boost::source(*ei, graph_);
+    vertex_t v = boost::target(*ei, graph_);
+    if (scc[u] == scc[v])
+      continue;
+    int lu = std::min(depth[scc[u]], maxpath);
+    int lv = std::min(depth[scc[v]], maxpath);
+    if (lu < lv) {
+      reached[scc[v]] = 1;
+      continue;
+    }
+    removed.push_back(*ei);
+    if (lu > lv) {
+      added.emplace_back(v, u);
+      reached[scc[u]] = 1;
+    }
+  }
+
+  // edges live in list for bidirectional graph, so rest of descriptors
+  // stay valid. Inverted edge is not added twice
+  for (auto e : removed)
+    boost::remove_edge(e, graph_);
+  for (auto [u, v] : added)
+    if (!boost::edge(u, v, graph_).second)
+      boost::add_edge(u, v, graph_);
+
+  for (int c = 0; c < nscc; ++c)
+    if (depth[c] > 0 && !reached[c])
+      boost::add_edge(sccrep[anchor[c]], sccrep[c], graph_);
+}
+
+void callgraph_t::add_self_loops() {
   for (auto [vi, vi_end] = boost::vertices(graph_); vi != vi_end; ++vi)
     if (cfg::get(config_, CG::SELFLOOP))
       boost::add_edge(*vi, *vi, graph_);
 
-  // setting direct calls
-  boost::breadth_first_search(graph_, main_head,
-                              boost::visitor(bfs_edge_visitor{}));
+  // setting direct calls: spanning tree from main, every direct call is
+  // call site in controlgraph, so every function is called
+  vertex_t mainf = main_func();
+  boost::queue<vertex_t> bfsq;
+  std::vector<boost::default_color_type> colors(boost::num_vertices(graph_));
+  boost::breadth_first_search(
+      graph_, &mainf, &mainf + 1, bfsq, bfs_edge_visitor{},
+      boost::make_iterator_property_map(
+          colors.begin(), boost::get(boost::vertex_index, graph_)));
+
+  if (std::any_of(colors.begin(), colors.end(), [](auto c) {
+        return c == boost::white_color;
+      }))
+    throw std::runtime_error("Function unreachable from main");
 }
 
+// heads of secondary components are taken first, connect_components
+// guarantees there is room for all of them
 void callgraph_t::create_indcalls() {
   cfg::config_rng cfrng(config_);
-  int nindirect = cfg::get(config_, CG::INDSETCNT);
-  if ((comps_.size() > 1) && (nindirect > 0))
-    for (auto it = comps_.begin() + 1; it != comps_.end(); ++it)
-      for (auto vi : *it) {
-        nindirect -= 1;
-        inds_.push_back(vi);
-        if (nindirect == 0)
-          break;
-      }
+  int nindirect = nindirect_;
+
+  for (auto it = comps_.begin() + 1; it != comps_.end(); ++it)
+    inds_.push_back((*it)[0]);
+  nindirect -= inds_.size();
+  assert(nindirect >= 0);
+
+  for (auto it = comps_.begin() + 1; it != comps_.end() && nindirect > 0; ++it)
+    for (auto vit = it->begin() + 1; vit != it->end() && nindirect > 0; ++vit) {
+      inds_.push_back(*vit);
+      nindirect -= 1;
+    }
 
   if (nindirect > 0)
     std::sample(comps_[0].begin() + 1, comps_[0].end(),
@@ -436,6 +662,154 @@ void callgraph_t::create_indcalls() {
 #endif
 }
 
+// builds callee_offs_/callees_ and caller_offs_/callers_
+// calltype order inside each vertex is DIRECT, CONDITIONAL, INDIRECT
+void callgraph_t::freeze_adjacency() {
+  int nv = boost::num_vertices(graph_);
+  const calltype_t edgetypes[] = {calltype_t::DIRECT, calltype_t::CONDITIONAL};
+
+  callee_offs_.clear();
+  callees_.clear();
+  caller_offs_.clear();
+  callers_.clear();
+  callee_offs_.reserve(nv * NCALLTYPES + 1);
+  caller_offs_.reserve(nv * NCALLTYPES + 1);
+  callees_.reserve(boost::num_edges(graph_) + nv * inds_.size());
+  callers_.reserve(boost::num_edges(graph_) + nv * inds_.size());
+
+  for (int v = 0; v < nv; ++v) {
+    for (auto ct : edgetypes) {
+      callee_offs_.push_back(callees_.size());
+      for (auto [ei, ei_end] = boost::out_edges(v, graph_); ei != ei_end; ++ei)
+        if (graph_[*ei].calltype == ct)
+          callees_.push_back(boost::target(*ei, graph_));
+
+      caller_offs_.push_back(callers_.size());
+      for (auto [ei, ei_end] = boost::in_edges(v, graph_); ei != ei_end; ++ei)
+        if (graph_[*ei].calltype == ct)
+          callers_.push_back(boost::source(*ei, graph_));
+    }
+
+    // everybody may call indirect set members through pointer
+    callee_offs_.push_back(callees_.size());
+    callees_.insert(callees_.end(), inds_.begin(), inds_.end());
+
+    caller_offs_.push_back(callers_.size());
+    if (graph_[v].indset != 0)
+      for (int u = 0; u < nv; ++u)
+        callers_.push_back(u);
+  }
+
+  callee_offs_.push_back(callees_.size());
+  caller_offs_.push_back(callers_.size());
+}
+
+// Reachability index
+// Tarjan numbers SCCs in reverse topological order (callee SCC is finished
+// before caller SCC), so renumbering is just nscc - 1 - id
+// Transitive callees are collected from sinks up: reach(c) is union of
+// {d} and reach(d) for every successor d of c. Every such set lives in
+// window [c + 1, nscc) and in practice much narrower, so only words between
+// least and greatest reachable SCC are stored
+// Indirect calls are not here: everybody may call indirect set, so they are
+// chosen to not close cycles instead (see controlgraph random_callee and
+// rank_indirect)
+void callgraph_t::build_reachability() {
+  const calltype_t real = calltype_t::DIRECT | calltype_t::CONDITIONAL;
+  int nv = nfuncs();
+  auto vindex = boost::get(boost::vertex_index, graph_);
+
+  scc_.assign(nv, 0);
+  int nscc = boost::strong_components(
+      graph_, boost::make_iterator_property_map(scc_.begin(), vindex));
+  for (auto &c : scc_)
+    c = nscc - 1 - c;
+
+  // functions grouped by SCC
+  std::vector<int> members_offs(nscc + 1, 0);
+  std::vector<vertex_t> members(nv);
+  for (int v = 0; v < nv; ++v)
+    members_offs[scc_[v] + 1] += 1;
+  std::partial_sum(members_offs.begin(), members_offs.end(),
+                   members_offs.begin());
+  std::vector<int> fill(members_offs.begin(), members_offs.end() - 1);
+  for (int v = 0; v < nv; ++v)
+    members[fill[scc_[v]]++] = v;
+
+  recursive_.assign(nscc, 0);
+  reach_lo_.assign(nscc, 0);
+  reach_offs_.assign(nscc + 1, 0);
+  reach_bits_.clear();
+
+  // SCC windows are computed from sinks, but stored from sources, so first
+  // collect them into separate vectors
+  std::vector<std::vector<std::uint64_t>> bits(nscc);
+  std::vector<int> succs;
+  for (int c = nscc - 1; c >= 0; --c) {
+    succs.clear();
+    int size = members_offs[c + 1] - members_offs[c];
+    for (int i = members_offs[c]; i != members_offs[c + 1]; ++i) {
+      vertex_t v = members[i];
+      for (auto it = callees_begin(v, real), ite = callees_end(v, real);
+           it != ite; ++it) {
+        if (scc_[*it] != c)
+          succs.push_back(scc_[*it]);
+        else if (*it == v)
+          recursive_[c] = 1;
+      }
+    }
+    if (size > 1)
+      recursive_[c] = 1;
+    if (succs.empty())
+      continue;
+
+    int lo = nscc, hi = -1;
+    for (int d : succs) {
+      int dlo = d / 64, dhi = d / 64;
+      if (!bits[d].empty())
+        dhi = std::max(dhi, reach_lo_[d] + int(bits[d].size()) - 1);
+      lo = std::min(lo, dlo);
+      hi = std::max(hi, dhi);
+    }
+
+    auto &cbits = bits[c];
+    cbits.assign(hi - lo + 1, 0);
+    reach_lo_[c] = lo;
+    for (int d : succs) {
+      cbits[d / 64 - lo] |= std::uint64_t(1) << (d % 64);
+      for (int w = 0, we = bits[d].size(); w != we; ++w)
+        cbits[reach_lo_[d] + w - lo] |= bits[d][w];
+    }
+  }
+
+  for (int c = 0; c < nscc; ++c) {
+    reach_offs_[c] = reach_bits_.size();
+    reach_bits_.insert(reach_bits_.end(), bits[c].begin(), bits[c].end());
+  }
+  reach_offs_[nscc] = reach_bits_.size();
+}
+
+// Indirect call ranks
+// Members of indirect set are ranked in order of inds_, f may call g
+// indirectly only if rank of g is greater than rank of every member, which
+// reaches f by direct and conditional calls (or is f). Cycle through
+// indirect calls f1 -> g1 ~> f2 -> g2 ~> ... ~> f1 would need growing ranks
+// all the way round, so there is none. Single indirect call f -> g closing
+// cycle through real calls is excluded as well: g reaches f
+// O(V * |inds_|) reachability queries
+void callgraph_t::rank_indirect() {
+  int nv = nfuncs();
+  indrank_.assign(nv, -1);
+  indreach_.assign(nsccs(), -1);
+  for (int r = 0, re = inds_.size(); r != re; ++r)
+    indrank_[inds_[r]] = r;
+
+  for (int v = 0; v < nv; ++v)
+    for (int r = 0, re = inds_.size(); r != re; ++r)
+      if (inds_[r] == vertex_t(v) || may_reach(inds_[r], v))
+        indreach_[scc_[v]] = std::max(indreach_[scc_[v]], r);
+}
+
 void callgraph_t::decide_metastructure() {
   // for all indirect calls same metastructure
   auto ind_metainfo = ms::random_meta(config_);
@@ -454,7 +828,32 @@ void callgraph_t::decide_metastructure() {
   }
 }
 
-// single function to call from accept_abi_type and accept_type(id, tid)
+// check every type against every metastructure class once
+// (there are only NMETACLASSES of them, while functions are many)
+void callgraph_t::build_accept_tables() {
+  int ntypes = tgraph_->ntypes();
+  accept_words_ = (ntypes + 63) / 64;
+  accept_bits_.assign(ms::NMETACLASSES * accept_words_, 0);
+  accepted_.assign(ms::NMETACLASSES, {});
+
+  for (int c = 0; c < ms::NMETACLASSES; ++c) {
+    ms::metanode_t m;
+    m.usesigned = c & 1;
+    m.usefloat = (c >> 1) & 1;
+    m.usecomplex = (c >> 2) & 1;
+    m.usepointers = (c >> 3) & 1;
+    assert(ms::meta_class(m) == c);
+
+    auto *bits = &accept_bits_[c * accept_words_];
+    for (int t = 0; t < ntypes; ++t)
+      if (accept_type(m, tgraph_->vertex_from(t))) {
+        bits[t / 64] |= std::uint64_t(1) << (t % 64);
+        accepted_[c].push_back(t);
+      }
+  }
+}
+
+// single function to call from accept_abi_type and build_accept_tables
 bool callgraph_t::accept_type(ms::metanode_t m, tg::vertexprop_t vpt) const {
   return ms::check_type(m, vpt);
 }
@@ -528,7 +927,161 @@ void callgraph_t::assign_types() {
   }
 }
 
-void callgraph_t::map_modules() {}
+// names_ are pairs: 2 * v is function name and 2 * v + 1 is its signature
+// like "T3 foo5(A2, S4)"
+void callgraph_t::intern_names() {
+  int nv = nfuncs();
+  names_.reserve(nv * 2, nv * 32);
+  for (int v = 0; v < nv; ++v) {
+    const vertexprop_t &vp = graph_[v];
+    names_.add_numbered("foo", vp.funcid);
+
+    if (vp.rettype == -1)
+      names_.append("void");
+    else
+      names_.append(tgraph_->short_name(vp.rettype));
+    names_.append(" foo");
+    names_.append(vp.funcid);
+    names_.append("(");
+    for (auto ait = vp.argtypes.begin(); ait != vp.argtypes.end(); ++ait) {
+      if (ait != vp.argtypes.begin())
+        names_.append(", ");
+      names_.append(tgraph_->short_name(*ait));
+    }
+    names_.append(")");
+    names_.seal();
+  }
+}
+
+// Module partitioning
+// every function costs roughly splits x vars: each split is expected to
+// touch most of function variables. Calls are splits too and arguments are
+// variables too, so (E[MS::SPLITS] + ncallees) x (E[MS::NVARS] + nargs)
+// 1. initial partition: BFS over call edges (both directions) from main,
+//    cutting next module when prefix weight reaches its share of total
+// 2. FM-style refinement passes: move boundary function to module where
+//    most of its neighbours are, if this reduces cut or improves balance
+//    without breaking MODULE_IMBALANCE limit
+// indirect calls are not counted in cut: they are calls through pointer
+void callgraph_t::map_modules() {
+  constexpr double MODULE_IMBALANCE = 1.05;
+  constexpr int REFINE_PASSES = 8;
+  const calltype_t real = calltype_t::DIRECT | calltype_t::CONDITIONAL;
+
+  int nv = nfuncs();
+  int nmods = std::clamp(cfg::get(config_, CG::MODULES), 1, nv);
+
+  auto [smin, smax] = cfg::minmax(config_, MS::SPLITS);
+  auto [vmin, vmax] = cfg::minmax(config_, MS::NVARS);
+  double splits_mid = (smin + smax) / 2.0;
+  double nvars_mid = (vmin + vmax) / 2.0;
+
+  std::vector<double> weight(nv);
+  double total = 0.0;
+  for (int v = 0; v < nv; ++v) {
+    weight[v] = (splits_mid + ncallees(v, real)) *
+                (nvars_mid + graph_[v].argtypes.size());
+    total += weight[v];
+  }
+
+  auto for_each_nbr = [this, real](vertex_t v, auto f) {
+    for (auto it = callees_begin(v, real), ite = callees_end(v, real);
+         it != ite; ++it)
+      if (*it != v)
+        f(*it);
+    for (auto it = callers_begin(v, real), ite = callers_end(v, real);
+         it != ite; ++it)
+      if (*it != v)
+        f(*it);
+  };
+
+  // initial partition
+  std::vector<int> part(nv, -1);
+  std::vector<double> modweight(nmods, 0.0);
+  std::vector<vertex_t> bfsq;
+  bfsq.reserve(nv);
+  std::vector<char> seen(nv, 0);
+  int curmod = 0;
+  double acc = 0.0;
+  vertex_t start = comps_[0][0];
+  for (int s = -1; s < nv; ++s) {
+    vertex_t root = (s < 0) ? start : s;
+    if (seen[root])
+      continue;
+    seen[root] = 1;
+    bfsq.push_back(root);
+    for (size_t qidx = bfsq.size() - 1; qidx < bfsq.size(); ++qidx) {
+      vertex_t v = bfsq[qidx];
+      if (curmod + 1 < nmods && acc >= total * (curmod + 1) / nmods)
+        curmod += 1;
+      part[v] = curmod;
+      modweight[curmod] += weight[v];
+      acc += weight[v];
+      for_each_nbr(v, [&bfsq, &seen](vertex_t u) {
+        if (!seen[u]) {
+          seen[u] = 1;
+          bfsq.push_back(u);
+        }
+      });
+    }
+  }
+
+  // refinement
+  double limit = MODULE_IMBALANCE * total / nmods;
+  std::vector<int> conn(nmods, 0);
+  std::vector<int> touched;
+  for (int pass = 0; pass < REFINE_PASSES; ++pass) {
+    int nmoves = 0;
+    for (vertex_t v : bfsq) {
+      int from = part[v];
+      touched.clear();
+      for_each_nbr(v, [&](vertex_t u) {
+        if (conn[part[u]]++ == 0)
+          touched.push_back(part[u]);
+      });
+
+      int best = from;
+      int bestgain = 0;
+      for (int to : touched) {
+        if (to == from)
+          continue;
+        int gain = conn[to] - conn[from];
+        double wto = modweight[to] + weight[v];
+        bool fits = wto <= limit;
+        bool balances = wto < modweight[from];
+        if ((gain > bestgain && (fits || balances)) ||
+            (gain == bestgain && gain >= 0 && balances))
+          best = to, bestgain = gain;
+      }
+
+      for (int m : touched)
+        conn[m] = 0;
+      conn[from] = 0;
+
+      if (best != from) {
+        part[v] = best;
+        modweight[from] -= weight[v];
+        modweight[best] += weight[v];
+        nmoves += 1;
+      }
+    }
+    if (nmoves == 0)
+      break;
+  }
+
+  modules_.assign(nmods, {});
+  for (int v = 0; v < nv; ++v) {
+    graph_[v].moduleno = part[v];
+    modules_[part[v]].push_back(v);
+  }
+
+#if 0
+  std::cout << "Modules:" << std::endl;
+  for (int m = 0; m < nmods; ++m)
+    std::cout << m << ": " << modules_[m].size() << " functions, weight "
+              << modweight[m] << std::endl;
+#endif
+}
 
 } // namespace cg
 
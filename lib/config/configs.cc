@@ -306,6 +306,15 @@ std::pair<int, int> config::minmax(int id) const {
   return std::make_pair(d.from, d.to);
 }
 
+// get() draws from [0, total] inclusive, so there are total + 1 outcomes
+double config::pflag_prob(int id) const {
+  auto fit = cfg_.find(id);
+  if (fit == cfg_.end())
+    throw std::runtime_error("Config have no such value");
+  const cfg::pflag &pf = std::get<cfg::pflag>(fit->second);
+  return std::clamp(double(pf.prob) / (pf.total + 1), 0.0, 1.0);
+}
+
 size_t config::prob_size(int id) const {
   auto fit = cfg_.find(id);
   if (fit == cfg_.end())
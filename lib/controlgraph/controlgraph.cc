@@ -5,15 +5,15 @@
 // split tree is slightly tricky
 // it have labeled childs (order of childs in node is important)
 // so boost graph is bad decision, and thus it is modeled by:
-// (1) child list for each vertex
-// (2) unordered map from vertex to its parent
-// (3) unordered map from vertex to its bundled description
-// (4) unordered set of vertices which are bbs, available to split
+// (1) intrusive semitree of nodes from per-function pool, vertex is index
+//     of node in pool, node keeps its record
+// (2) defs and uses of all nodes in CSR arrays
+// (3) indexable set of vertices which are bbs, available to split
 //
 // Then typical split is trivial:
 // * we are choosing random block from (3)
-// * we are selecting its parent from (2)
-// * we are making split in parents adjlist
+// * we are selecting its parent from (1)
+// * we are relinking new siblings next to it
 //
 //------------------------------------------------------------------------------
 //
@@ -22,6 +22,7 @@
 //
 //------------------------------------------------------------------------------
 
+#include <algorithm>
 #include <iostream>
 #include <iterator>
 #include <list>
@@ -35,7 +36,9 @@
 #include "callgraph/callgraph.h"
 #include "callgraph/calliters.h"
 #include "coelacanth/dbgstream.h"
+#include "coelacanth/tasksystem.h"
 #include "controlgraph.h"
+#include "costmodel.h"
 #include "splittree.h"
 #include "typegraph/typegraph.h"
 #include "varassign/varassign.h"
@@ -134,8 +137,8 @@ std::ostream &operator<<(std::ostream &os, const vertexprop_t &v) {
   return os;
 }
 
-std::string vertexprop_t::varname(va::variable_t v) const {
-  return parent_.varname(v);
+std::string_view vertexprop_t::varname(va::variable_t v) const {
+  return parent_->varname(v);
 }
 
 //------------------------------------------------------------------------------
@@ -153,35 +156,103 @@ controlgraph_t::controlgraph_t(cfg::config &&cf,
   if (!config_.quiet())
     dbgs() << "Creating controlgraph\n";
 
-  strees_.resize(cgraph_->nfuncs());
-
-  // for every call-graph function
-  for (auto cgv : *cgraph_) {
-    int cgvi = static_cast<int>(cgv);
-    assert(cgvi < cgraph_->nfuncs());
+  int nfuncs = cgraph_->nfuncs();
+  strees_.resize(nfuncs);
+  budget_.assign(nfuncs, 0);
+  wave_.assign(nfuncs, 0);
+  total_.assign(nfuncs, 0);
+  if (cost_t total = cfg::get(config_, CN::BUDGET); total != 0)
+    plan_budget(total);
+
+  // split trees only read shared graphs, so every call-graph function of
+  // wave gets own task. Every tree have own random stream derived from
+  // seed, so result do not depend on scheduling
+  int seed = config_.rand_positive();
+  auto build_tree = [this, seed](int cgvi) {
+    cg::vertex_t cgv = cgvi;
 
     // can not use make_unique here (because we have custom deleter for stt)
-    auto *pst = new split_tree_t{*this, config_, vassign_, cgvi};
+    auto *pst = new split_tree_t{*this, config_, vassign_, cgvi,
+                                 cfg::derive_seed(seed, cgvi)};
     auto st = stt{pst};
     strees_[cgvi] = std::move(st);
 
     vct seeds;
-    const split_tree_t &parent = *strees_[cgvi];
-
-    seeds.emplace_back(create_vprop<block_t>(parent));
+    seeds.emplace_back(create_vprop<block_t>());
 
     // initial seeds are direct calls
     for (auto cit = cgraph_->callees_begin(cgv, cg::calltype_t::DIRECT);
          cit != cgraph_->callees_end(cgv, cg::calltype_t::DIRECT); ++cit) {
-      seeds.emplace_back(
-          create_vprop<call_t>(parent, call_type_t::DIRECT, int(*cit)));
-      seeds.emplace_back(create_vprop<block_t>(parent));
+      seeds.emplace_back(create_vprop<call_t>(call_type_t::DIRECT, int(*cit)));
+      seeds.emplace_back(create_vprop<block_t>());
     }
 
     strees_[cgvi]->process(seeds.begin(), seeds.end());
+  };
+
+  int nwaves = *std::max_element(wave_.begin(), wave_.end()) + 1;
+  std::vector<std::vector<int>> waves(nwaves);
+  for (int f = 0; f != nfuncs; ++f)
+    waves[wave_[f]].push_back(f);
+
+  for (auto &w : waves) {
+    parallel_for(w.size(), [&w, &build_tree](int n) { build_tree(w[n]); });
+    for (int f : w)
+      total_[f] = strees_[f]->cost();
   }
 }
 
+// SCCs are numbered callers first, so budgets are shared from first SCC
+// and waves are found from last one
+//
+// function calls all its direct callees (they are seeds), so after seeds
+// it leaves equal shares of its budget to every callee in other SCC and to
+// itself. Callee gets least share of all its callers. Calls inside SCC are
+// recursion and not counted (cost model has only lower bound for it)
+void controlgraph_t::plan_budget(cost_t total) {
+  const cg::calltype_t real =
+      cg::calltype_t::DIRECT | cg::calltype_t::CONDITIONAL;
+  int nfuncs = cgraph_->nfuncs();
+  std::vector<std::vector<int>> members(cgraph_->nsccs());
+  for (int f = 0; f != nfuncs; ++f)
+    members[cgraph_->scc_of(f)].push_back(f);
+
+  int nsccs = members.size();
+  std::vector<cost_t> scc_budget(nsccs, total);
+  for (int c = 0; c != nsccs; ++c)
+    for (int f : members[c]) {
+      budget_[f] = scc_budget[c];
+      cost_t seeds = 1, nshares = 1;
+      for (auto it = cgraph_->callees_begin(f, cg::calltype_t::DIRECT),
+                ie = cgraph_->callees_end(f, cg::calltype_t::DIRECT);
+           it != ie; ++it) {
+        seeds += 2;
+        nshares += (cgraph_->scc_of(*it) != c);
+      }
+
+      // budget 0 is unlimited, so least share is 1
+      cost_t left = budget_[f] > seeds ? budget_[f] - seeds : 0;
+      cost_t share = std::max<cost_t>(left / nshares, 1);
+      for (auto it = cgraph_->callees_begin(f, real),
+                ie = cgraph_->callees_end(f, real);
+           it != ie; ++it)
+        if (int cc = cgraph_->scc_of(*it); cc != c)
+          scc_budget[cc] = std::min(scc_budget[cc], share);
+    }
+
+  std::vector<int> scc_wave(nsccs, 0);
+  for (int c = nsccs - 1; c >= 0; --c)
+    for (int f : members[c])
+      for (auto it = cgraph_->callees_begin(f, real),
+                ie = cgraph_->callees_end(f, real);
+           it != ie; ++it)
+        if (int cc = cgraph_->scc_of(*it); cc != c)
+          scc_wave[c] = std::max(scc_wave[c], scc_wave[cc] + 1);
+
+  for (int f = 0; f != nfuncs; ++f)
+    wave_[f] = scc_wave[cgraph_->scc_of(f)];
+}
+
 int controlgraph_t::nfuncs() const { return cgraph_->nfuncs(); }
 
 vertex_iter_t controlgraph_t::begin(int nfunc) const {
@@ -200,28 +271,48 @@ vertex_iter_t controlgraph_t::end_childs(int nfunc, vertex_t parent) const {
   return strees_[nfunc]->end_childs(parent);
 }
 
-shared_vp_t controlgraph_t::from_vertex(int nfunc, vertex_t v) const {
+vertexprop_t controlgraph_t::from_vertex(int nfunc, vertex_t v) const {
   return strees_[nfunc]->from_vertex(v);
 }
 
-std::string controlgraph_t::varname(int nfunc, int vid) const {
-  return vassign_->get_name(vid, nfunc);
+std::string_view controlgraph_t::varname(int vid) const {
+  return vassign_->get_name(vid);
 }
 
-int controlgraph_t::random_callee(int nfunc, call_type_t) const {
-  // TODO: fix after callgraph support (shall be call-type related)
-  cg::calltype_t mask = cg::calltype_t::CONDITIONAL;
-
-  auto it = cgraph_->callees_begin(nfunc, mask);
-  auto eit = cgraph_->callees_end(nfunc, mask);
-
-  int dist = std::distance(it, eit);
+int controlgraph_t::random_callee(int nfunc, call_type_t ctp,
+                                  const cfg::config &cf) const {
+  cg::calltype_t mask = cg::calltype_t::DIRECT;
+  switch (ctp) {
+  case call_type_t::DIRECT:
+    break;
+  case call_type_t::CONDITIONAL:
+    mask = cg::calltype_t::CONDITIONAL;
+    break;
+  case call_type_t::INDIRECT:
+    mask = cg::calltype_t::INDIRECT;
+    break;
+  default:
+    throw std::runtime_error("Unknown call type");
+  }
 
-  if (dist == 0)
+  int ncallees = cgraph_->ncallees(nfunc, mask);
+  if (ncallees == 0)
     return -1;
 
-  std::advance(it, config_.rand_positive() % dist);
-  return *it;
+  auto callees = cgraph_->callees_begin(nfunc, mask);
+  int start = cf.rand_positive() % ncallees;
+  if (ctp != call_type_t::INDIRECT)
+    return callees[start];
+
+  // indirect call shall not close a cycle, see callgraph rank_indirect
+  for (int i = 0; i != ncallees; ++i) {
+    int callee = callees[(start + i) % ncallees];
+    if (cgraph_->may_call_indirect(nfunc, callee) &&
+        (budget_[nfunc] == 0 || wave_[callee] < wave_[nfunc]))
+      return callee;
+  }
+
+  return -1;
 }
 
 void controlgraph_t::dump(std::ostream &os) const {
@@ -232,6 +323,8 @@ void controlgraph_t::dump(std::ostream &os) const {
     t->dump(os);
     os << "---" << std::endl << std::endl;
   }
+
+  cost_model_t(*this, *cgraph_).dump(os);
 }
 
 } // namespace cn
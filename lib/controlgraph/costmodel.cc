@@ -0,0 +1,137 @@
+//------------------------------------------------------------------------------
+//
+// Static runtime cost model for controlgraph impl
+//
+//------------------------------------------------------------------------------
+//
+// This file is licensed after LGPL v3
+// Look at: https://www.gnu.org/licenses/lgpl-3.0.en.html for details
+//
+//------------------------------------------------------------------------------
+
+#include <utility>
+
+#include "callgraph/callgraph.h"
+#include "controlgraph.h"
+#include "costmodel.h"
+
+namespace cn {
+
+namespace {
+
+// (callee, weight of call)
+using wcalls_t = std::vector<std::pair<int, cost_t>>;
+
+// body cost of nfunc and all its calls
+dyncost_t body_cost(const controlgraph_t &cn, int nfunc, wcalls_t &calls) {
+  dyncost_t res;
+  std::vector<vertex_t> s(cn.begin(nfunc), cn.end(nfunc));
+  while (!s.empty()) {
+    vertex_t v = s.back();
+    s.pop_back();
+    auto vp = cn.from_vertex(nfunc, v);
+    cost_t w = vp.nesting().weight;
+
+    if (vp.cat() == category_t::BLOCK)
+      res.blocks = cost_add(res.blocks, w);
+    if (vp.cat() == category_t::CALL) {
+      res.calls = cost_add(res.calls, w);
+      calls.emplace_back(std::get<call_t>(vp.type()).nfunc, w);
+    }
+
+    s.insert(s.end(), cn.begin_childs(nfunc, v), cn.end_childs(nfunc, v));
+  }
+  return res;
+}
+
+} // namespace
+
+cost_model_t::cost_model_t(const controlgraph_t &cn,
+                           const cg::callgraph_t &cg) {
+  int nfuncs = cn.nfuncs();
+  std::vector<wcalls_t> calls(nfuncs);
+  body_.resize(nfuncs);
+  total_.resize(nfuncs);
+  exact_.resize(nfuncs);
+  main_ = cg.main_func();
+
+  for (int f = 0; f != nfuncs; ++f) {
+    body_[f] = body_cost(cn, f, calls[f]);
+    exact_[f] = !cg.is_recursive(f);
+  }
+
+  // totals in callees-first order, found by DFS (indirect calls are not in
+  // SCC order, so SCC numbers are not enough). Callee still on stack means
+  // recursion, its total is not known and not added
+  enum { NEW, OPEN, DONE };
+  std::vector<char> state(nfuncs, NEW);
+  std::vector<std::pair<int, int>> stack; // function, next call to visit
+  for (int root = 0; root != nfuncs; ++root) {
+    if (state[root] != NEW)
+      continue;
+    state[root] = OPEN;
+    stack.emplace_back(root, 0);
+    while (!stack.empty()) {
+      auto &[f, ncall] = stack.back();
+      if (ncall < int(calls[f].size())) {
+        int callee = calls[f][ncall++].first;
+        if (state[callee] == NEW) {
+          state[callee] = OPEN;
+          stack.emplace_back(callee, 0);
+        }
+        continue;
+      }
+
+      dyncost_t tot = body_[f];
+      for (auto [callee, w] : calls[f]) {
+        if (state[callee] != DONE) {
+          exact_[f] = false;
+          continue;
+        }
+        exact_[f] = exact_[f] && exact_[callee];
+        tot.blocks = cost_add(tot.blocks, cost_mul(w, total_[callee].blocks));
+        tot.calls = cost_add(tot.calls, cost_mul(w, total_[callee].calls));
+      }
+      total_[f] = tot;
+      state[f] = DONE;
+      stack.pop_back();
+    }
+  }
+}
+
+namespace {
+
+// blocks / calls, saturated as inf
+struct costfmt_t {
+  const dyncost_t &c;
+};
+
+std::ostream &print(std::ostream &os, cost_t c) {
+  if (c == COST_INF)
+    return os << "inf";
+  return os << static_cast<unsigned long long>(c);
+}
+
+std::ostream &operator<<(std::ostream &os, costfmt_t cf) {
+  print(os, cf.c.blocks) << " / ";
+  return print(os, cf.c.calls);
+}
+
+} // namespace
+
+void cost_model_t::dump(std::ostream &os) const {
+  os << "Worst-case executed blocks / calls\n";
+  for (int f = 0, fe = body_.size(); f != fe; ++f) {
+    os << "<FOO" << f << ">: body " << costfmt_t{body_[f]} << ", total "
+       << costfmt_t{total_[f]};
+    if (!exact_[f])
+      os << " (recursion, lower bound)";
+    os << "\n";
+  }
+  os << "Program (from <FOO" << main_ << ">): " << costfmt_t{program()};
+  if (!program_exact())
+    os << " (recursion, lower bound)";
+  os << "\n";
+}
+
+} // namespace cn
@@ -9,7 +9,11 @@
 //
 //------------------------------------------------------------------------------
 
+#include <algorithm>
 #include <cassert>
+#include <iterator>
+#include <limits>
+#include <stack>
 
 #include "controlgraph.h"
 #include "controltypes.h"
@@ -19,113 +23,243 @@
 namespace cn {
 
 split_tree_t::split_tree_t(const controlgraph_t &p, const cfg::config &cf,
-                           std::shared_ptr<va::varassign_t> va, int nfunc)
-    : parent_(p), cf_(cf), vassign_(va), nfunc_(nfunc) {}
+                           std::shared_ptr<va::varassign_t> va, int nfunc,
+                           int seed)
+    : parent_(p), cf_(cf), vassign_(va), nfunc_(nfunc) {
+  cf_.reseed(seed);
+  budget_ = parent_.budget(nfunc_);
+}
 
 void split_tree_t::process(vcit start, vcit fin) {
   static_assert(PSEUDO_VERTEX == 0,
                 "We will have problems here if pseudo tp is not 0");
-  assert(adj_.size() == 0 &&
+  assert(pool_.empty() &&
          "We will have problems here if process called more than once");
-  adj_.resize(fin - start + 1);
-  int vidx = 1;
-  parent_of_[PSEUDO_VERTEX] = ILLEGAL_VERTEX;
-  desc_of_[PSEUDO_VERTEX] = nullptr;
+  add_node(node_t{});
+  auto &root = pool_[PSEUDO_VERTEX];
 
   // initial seeds
-  for (vcit cur = start; cur != fin; ++cur, ++vidx) {
-    adj_[PSEUDO_VERTEX].push_back(vidx);
-    desc_of_[vidx] = *cur;
-    parent_of_[vidx] = PSEUDO_VERTEX;
-    if ((*cur)->is_block())
-      bbs_.insert(vidx);
+  for (vcit cur = start; cur != fin; ++cur) {
+    vertex_t vidx = add_node(*cur);
+    root.insert(root.end(), pool_[vidx]);
+    nest_under(vidx, PSEUDO_VERTEX);
+    count(vidx);
+    if (cur->is_block())
+      bb_insert(vidx);
   }
 
   // do splits
+  // when budget allows no more blocks, special node takes block without
+  // replacement, so blocks may run out before splits do
   int nsplits = cfg::get(cf_, MS::SPLITS);
-  for (int i = 0; i < nsplits; ++i) {
+  for (int i = 0; i < nsplits && !bbs_.empty(); ++i) {
     int navail = bbs_.size();
-    auto bbit = bbs_.begin();
-    std::advance(bbit, cf_.rand_positive() % navail);
-    do_split(*bbit);
+    do_split(bbs_[cf_.rand_positive() % navail]);
   }
 
-  // assign variables
-  for (size_t i = 1; i < adj_.size(); ++i)
-    assign_vars_to(desc_of_[i]);
-
-  // add accblocks
-  // THIS -> CHILDS into THIS -> ACCS, ACC -> CHILD
-  size_t cursize = adj_.size();
-  for (size_t i = 1; i < cursize; ++i) {
-    // for all childs of current block
-    // counting accs
-    // creating accblock with index vars
-    // making child into child of accblock
-    // replacing child with its accblock in parent
+  // assign variables, node by node, so CSR is filled in order
+  int nvertices = pool_.size();
+  var_offs_.reserve(2 * nvertices + 1);
+  var_offs_.push_back(0);
+  var_offs_.push_back(0);
+  var_offs_.push_back(0);
+  for (int i = 1; i < nvertices; ++i)
+    assign_vars_to(pool_[i].rec);
+
+  add_accblocks();
+}
+
+// add accblocks
+// THIS -> CHILDS into THIS -> ACCS, ACC -> CHILD
+// for every child using variables with accessors. Accblock defines index
+// variables of those accessors. Single preorder sweep over snapshot of
+// tree: parent is final when its childs are visited, so nesting (now with
+// access category) is refreshed on the way
+void split_tree_t::add_accblocks() {
+  auto nodes = semitree::flatten(pool_[PSEUDO_VERTEX]);
+  int nnodes = nodes.size();
+
+  // calls f for index variables of v, each once
+  std::vector<int> stamp(vassign_->nvars(), -1);
+  int epoch = 0;
+  auto for_indexes = [&](vertex_t v, auto f) {
+    epoch += 1;
+    for (int n = var_offs_[2 * v], ne = var_offs_[2 * v + 2]; n != ne; ++n) {
+      int vid = vars_[n].id;
+      for (auto it = vassign_->accs_begin(nfunc_, vid),
+                ie = vassign_->accs_end(nfunc_, vid);
+           it != ie; ++it) {
+        if (stamp[*it] == epoch)
+          continue;
+        stamp[*it] = epoch;
+        f(*it);
+      }
+    }
+  };
+
+  // counting accs to reserve everything at once
+  std::vector<int> naccs(nnodes);
+  int nblocks = 0, nidxs = 0;
+  for (int i = 0; i != nnodes; ++i) {
+    for_indexes(vertex_of(*nodes[i].node), [&](int) { naccs[i] += 1; });
+    nblocks += (naccs[i] > 0);
+    nidxs += naccs[i];
+  }
+  pool_.reserve(pool_.size() + nblocks);
+  bbidx_.reserve(bbidx_.size() + nblocks);
+  var_offs_.reserve(var_offs_.size() + 2 * nblocks);
+  vars_.reserve(vars_.size() + nidxs);
+
+  for (int i = 0; i != nnodes; ++i) {
+    vertex_t child = vertex_of(*nodes[i].node);
+    vertex_t parent = parent_of(child);
+
+    if (naccs[i] > 0) {
+      // creating accblock with index vars (defs) and no uses
+      vertex_t acc = add_node(create_vprop<access_t>());
+      for_indexes(child, [&](int idx) { vars_.push_back(vassign_->at(idx)); });
+      var_offs_.push_back(vars_.size());
+      var_offs_.push_back(vars_.size());
+
+      // replacing child with its accblock in parent
+      // making child into child of accblock
+      pool_[parent].insert(pool_[child].get_sibling_iterator(), pool_[acc]);
+      pool_[acc].move(pool_[acc].end(), pool_[child]);
+      nest_under(acc, parent);
+      parent = acc;
+    }
+
+    nest_under(child, parent);
   }
 }
 
 // vertex property from desc
-shared_vp_t split_tree_t::from_vertex(vertex_t v) const {
-  auto vit = desc_of_.find(v);
-  if (vit == desc_of_.end())
+vertexprop_t split_tree_t::from_vertex(vertex_t v) const {
+  if (v < 0 || v >= pool_.size())
     throw std::runtime_error("Vertex not found");
-  return vit->second;
+  assert(2 * v + 2 < int(var_offs_.size()));
+  const va::variable_t *vars = vars_.data();
+  return vertexprop_t(*this, pool_[v].rec, pool_[v].nest,
+                      vars + var_offs_[2 * v], vars + var_offs_[2 * v + 1],
+                      vars + var_offs_[2 * v + 2]);
 }
 
 // variable name from desc
-std::string split_tree_t::varname(va::variable_t v) const {
-  return parent_.varname(nfunc_, v.id);
+std::string_view split_tree_t::varname(va::variable_t v) const {
+  return parent_.varname(v.id);
 }
 
 // tree-like print of controlgraph
 void split_tree_t::dump(std::ostream &os) const {
-  using stackelem_t = std::pair<int, vertex_t>;
-  std::stack<stackelem_t> s;
-  for (auto ri = adj_[PSEUDO_VERTEX].rbegin(), re = adj_[PSEUDO_VERTEX].rend();
-       ri != re; ++ri)
-    s.push(std::make_pair(0, *ri));
-  while (!s.empty()) {
-    auto [level, nvert] = s.top();
-    s.pop();
-
-    for (int i = 0; i < level; i++)
+  for (auto &e : semitree::flatten(pool_[PSEUDO_VERTEX])) {
+    for (int i = 0; i < 2 * e.depth; i++)
       os << " ";
-    os << *from_vertex(nvert) << "\n";
-
-    for (auto ri = adj_[nvert].rbegin(), re = adj_[nvert].rend(); ri != re;
-         ++ri)
-      s.push(std::make_pair(level + 2, *ri));
+    os << from_vertex(vertex_of(*e.node)) << "\n";
   }
 }
 
-// add block to list of childs at pos, return iterator
+// new orphan node in pool, returns its vertex
+vertex_t split_tree_t::add_node(const node_t &rec) {
+  vertex_t v = pool_.size();
+  pool_.create(v, rec);
+  bbidx_.push_back(-1);
+  return v;
+}
+
+vertex_t split_tree_t::parent_of(vertex_t v) const {
+  const ctl_node_t &n = pool_[v];
+  if (!n.has_parent())
+    return ILLEGAL_VERTEX;
+  return vertex_of(n.get_parent());
+}
+
+// v is just inserted as child of parent
+void split_tree_t::nest_under(vertex_t v, vertex_t parent) {
+  const ctl_node_t &p = pool_[parent];
+  pool_[v].nest = p.nest.child(parent, p.rec);
+}
+
+// blocks and calls are what cost model counts
+static bool counted(const node_t &n) {
+  return n.cat == category_t::BLOCK || n.cat == category_t::CALL;
+}
+
+// call costs itself and everything callee executes (see callee_cost)
+cost_t split_tree_t::node_cost(vertex_t v) const {
+  const ctl_node_t &n = pool_[v];
+  if (!counted(n.rec))
+    return 0;
+  if (n.rec.cat == category_t::BLOCK)
+    return n.nest.weight;
+  int callee = std::get<call_t>(n.rec.type).nfunc;
+  return cost_mul(n.nest.weight,
+                  cost_add(1, parent_.callee_cost(nfunc_, callee)));
+}
+
+void split_tree_t::count(vertex_t v) { cost_ = cost_add(cost_, node_cost(v)); }
+
+void split_tree_t::uncount(vertex_t v) {
+  cost_ = cost_sub(cost_, node_cost(v));
+}
+
+// how many more counted nodes of given weight fit into budget
+// unlimited is large, but leaves room to add a little
+int split_tree_t::fits(cost_t weight) const {
+  constexpr cost_t UNLIMITED = std::numeric_limits<int>::max() / 2;
+  if (budget_ == 0 || weight == 0)
+    return UNLIMITED;
+  if (cost_ >= budget_)
+    return 0;
+  return std::min((budget_ - cost_) / weight, UNLIMITED);
+}
+
+void split_tree_t::bb_insert(vertex_t v) {
+  if (bbidx_[v] != -1)
+    return;
+  bbidx_[v] = bbs_.size();
+  bbs_.push_back(v);
+}
+
+// swap with last and pop
+void split_tree_t::bb_erase(vertex_t v) {
+  int idx = bbidx_[v];
+  if (idx == -1)
+    return;
+  vertex_t last = bbs_.back();
+  bbs_[idx] = last;
+  bbidx_[last] = idx;
+  bbs_.pop_back();
+  bbidx_[v] = -1;
+}
+
+// add block to list of childs after pos, return iterator
 itpos_t split_tree_t::add_block(itpos_t pos, vertex_t parent) {
-  int nblock = adj_.size();
-  assert(parent < nblock);
-  adj_.emplace_back();
-  shared_vp_t prop = create_vprop<block_t>(*this);
-
-  itpos_t ret;
-  if (adj_[parent].empty()) {
-    adj_[parent].push_back(nblock);
-    ret = adj_[parent].begin();
+  assert(parent < pool_.size());
+  vertex_t nblock = add_node(create_vprop<block_t>());
+  ctl_node_t &p = pool_[parent];
+  ctl_node_t &n = pool_[nblock];
+
+  if (p.empty()) {
+    p.insert(p.end(), n);
   } else {
     // insert after
-    assert(pos != adj_[parent].end());
-    ret = adj_[parent].insert(++pos, nblock);
+    assert(pos != p.end());
+    p.insert(++pos, n);
   }
+  nest_under(nblock, parent);
+  count(nblock);
 
-  desc_of_[nblock] = prop;
-  parent_of_[nblock] = parent;
-  bbs_.insert(nblock);
-  return ret;
+  bb_insert(nblock);
+  return n.get_sibling_iterator();
 }
 
 // add container and childs to it
+// container replaces block with childs of the same (or, for loop, trips
+// times more) weight, so budget limits number of childs and trips
 void split_tree_t::add_container(int bb_under_split) {
   int nchilds = 1;
+  cost_t weight = pool_[bb_under_split].nest.weight;
+  int maxchilds = fits(weight) + 1;
   int cont_type = cfg::get(cf_, CN::CONTPROB);
   switch (cont_type) {
   case CNC_IF:
@@ -136,6 +270,8 @@ void split_tree_t::add_container(int bb_under_split) {
     int start = cfg::get(cf_, CN::FOR_START);
     int stop = start + cfg::get(cf_, CN::FOR_SIZE);
     int step = cfg::get(cf_, CN::FOR_STEP);
+    if (loop_t(start, stop, step).trips() > maxchilds)
+      stop = start + maxchilds * step;
     turn_block<loop_t>(bb_under_split, start, stop, step);
     break;
   }
@@ -150,41 +286,27 @@ void split_tree_t::add_container(int bb_under_split) {
   default:
     throw std::runtime_error("Unknown container");
   }
-  // need to reserve since all contents and iterators
-  // to it (including list iterators) can be invalidated
-  adj_.reserve(adj_.size() + nchilds);
+  nchilds = std::min(nchilds, maxchilds);
   std::stack<int> create_childs;
-  if (desc_of_[bb_under_split]->is_branching()) {
+  if (pool_[bb_under_split].rec.is_branching()) {
     for (int i = 0; i < nchilds; ++i) {
-      auto nb = add_block(adj_[bb_under_split].begin(), bb_under_split);
-      turn_block<branching_t>(*nb);
-      create_childs.push(*nb);
+      auto nb = add_block(pool_[bb_under_split].begin(), bb_under_split);
+      turn_block<branching_t>(vertex_of(*nb));
+      create_childs.push(vertex_of(*nb));
     }
   } else
     create_childs.push(bb_under_split);
   while (!create_childs.empty()) {
     int pbb = create_childs.top();
-    assert(pbb < int(adj_.size()));
+    assert(pbb < pool_.size());
     create_childs.pop();
-    add_block(adj_[pbb].begin(), pbb);
+    add_block(pool_[pbb].begin(), pbb);
   }
 }
 
 // does bb have pcat among his parents?
 bool split_tree_t::have_parent(int bb, category_t pcat) const {
-  shared_vp_t cur;
-
-  do {
-    auto pit = parent_of_.find(bb);
-    assert(pit != parent_of_.end());
-
-    bb = pit->second;
-    if (bb == PSEUDO_VERTEX)
-      break;
-    cur = from_vertex(bb);
-  } while (cur->cat() != pcat);
-
-  return (bb != PSEUDO_VERTEX);
+  return pool_[bb].nest.inside(pcat);
 }
 
 // add special node like break or call
@@ -216,8 +338,14 @@ void split_tree_t::add_special(int bb_under_split) {
     call_type_t ctp = call_type_t::INDIRECT;
     if (CNB_CCALL == block_type)
       ctp = call_type_t::CONDITIONAL;
-    int ncallee = parent_.random_callee(nfunc_, ctp);
-    if (-1 != ncallee)
+    int ncallee = parent_.random_callee(nfunc_, ctp, cf_);
+    if (-1 == ncallee)
+      break;
+
+    // call replaces block, so only callee shall fit
+    cost_t weight = pool_[bb_under_split].nest.weight;
+    cost_t callee = parent_.callee_cost(nfunc_, ncallee);
+    if (fits(cost_mul(weight, callee)) > 0)
       turn_block<call_t>(bb_under_split, ctp, ncallee);
     break;
   }
@@ -228,23 +356,14 @@ void split_tree_t::add_special(int bb_under_split) {
 
 void split_tree_t::do_split(int bb_under_split) {
   assert(bb_under_split != PSEUDO_VERTEX);
-  assert(parent_of_.find(bb_under_split) != parent_of_.end());
+  assert(parent_of(bb_under_split) != ILLEGAL_VERTEX);
 
   int naddblocks = cfg::get(cf_, CN::ADDBLOCKS);
-  // need to reserve since all contents and iterators
-  // to it (including list iterators) can be invalidated
-  adj_.reserve(adj_.size() + naddblocks);
+  naddblocks = std::min(naddblocks, fits(pool_[bb_under_split].nest.weight));
 
-  // 1. find position before this block in list of childs of its parent
-  int nbbp = parent_of_[bb_under_split];
-
-  auto nbit = adj_[nbbp].begin();
-  for (; nbit != adj_[nbbp].end(); ++nbit)
-    if (*nbit == bb_under_split)
-      break;
-
-  if (nbit == adj_[nbbp].end())
-    throw std::runtime_error("Not found in list of childs of its parent");
+  // 1. position of this block in list of childs of its parent
+  int nbbp = parent_of(bb_under_split);
+  itpos_t nbit = pool_[bb_under_split].get_sibling_iterator();
 
   // 2. add several more blocks
   if (naddblocks > 0) {
@@ -252,7 +371,7 @@ void split_tree_t::do_split(int bb_under_split) {
     for (int i = 0; i < naddblocks; ++i)
       nbnext = add_block(nbnext, nbbp);
     std::advance(nbit, cf_.rand_positive() % naddblocks);
-    bb_under_split = *nbit;
+    bb_under_split = vertex_of(*nbit);
   }
 
   // 3. Either:
@@ -264,7 +383,8 @@ void split_tree_t::do_split(int bb_under_split) {
     add_special(bb_under_split);
 }
 
-void split_tree_t::add_vars(int cntp, shared_vp_t svp) {
+// appends random variables to the end of vars_
+void split_tree_t::add_vars(int cntp) {
   auto vars_begin = vassign_->fv_begin(nfunc_);
   auto vars_end = vassign_->fv_end(nfunc_);
   int nvars = vars_end - vars_begin;
@@ -272,23 +392,23 @@ void split_tree_t::add_vars(int cntp, shared_vp_t svp) {
   int nuds = cfg::get(cf_, cntp);
   for (int i = 0; i < nuds; ++i) {
     int vid = *(vars_begin + (cf_.rand_positive() % nvars));
-    auto nsvp = std::const_pointer_cast<vertexprop_t>(svp);
-    nsvp->add_var(cntp, vassign_->at(vid));
+    vars_.push_back(vassign_->at(vid));
     // TODO: +all dependent
   }
 }
 
-void split_tree_t::assign_vars_to(shared_vp_t svp) {
-  if (svp->cat() == category_t::LOOP) {
-    // we have very special case for loops
-    return;
-  }
+// next node defs and uses, closing its two CSR ranges
+void split_tree_t::assign_vars_to(const node_t &n) {
+  // we have very special case for loops
+  bool isloop = (n.cat == category_t::LOOP);
 
-  if (svp->allow_defs())
-    add_vars(int(CN::DEFS), svp);
+  if (!isloop && n.allow_defs())
+    add_vars(int(CN::DEFS));
+  var_offs_.push_back(vars_.size());
 
-  if (svp->allow_uses())
-    add_vars(int(CN::USES), svp);
+  if (!isloop && n.allow_uses())
+    add_vars(int(CN::USES));
+  var_offs_.push_back(vars_.size());
 }
 
 void split_tree_deleter_t::operator()(split_tree_t *pst) { delete pst; }
@@ -0,0 +1,367 @@
+//------------------------------------------------------------------------------
+//
+// ExprIR: arithmetic expressions over LocIR locations
+//
+// Expressions are built node by node as trees of expr_t. Those are bumped in
+// builder arena, which is released after every function in one step, and are
+// hash-consed inside node, so equal subtrees are one object. Then roots are
+// walked in postorder and every distinct subtree is emitted once into postfix
+// array, which (with assigns) is the only thing copied to IR arena.
+//
+// Commutative operands are ordered by creation number, not by address, so
+// result do not depend on allocation.
+//
+//------------------------------------------------------------------------------
+//
+// This file is licensed after LGPL v3
+// Look at: https://www.gnu.org/licenses/lgpl-3.0.en.html for details
+//
+//------------------------------------------------------------------------------
+
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "callgraph/callgraph.h"
+#include "coelacanth/dbgstream.h"
+#include "coelacanth/tasksystem.h"
+#include "controlgraph/controlgraph.h"
+#include "exprir.h"
+#include "typegraph/typegraph.h"
+
+namespace ei {
+
+namespace {
+
+constexpr const char *op_names[] = {"", "", "", "-", "+",
+                                    "-", "*", "&", "|", "^"};
+
+static_assert(std::size(op_names) == int(op_t::OPMAX));
+
+bool is_commutative(op_t op) {
+  return op == op_t::ADD || op == op_t::MUL || op == op_t::AND ||
+         op == op_t::OR || op == op_t::XOR;
+}
+
+// expression tree node while building
+struct expr_t {
+  op_t op;
+  int type_id;
+  int imm;
+  const expr_t *lhs;
+  const expr_t *rhs;
+  int id;
+  mutable int post = -1; // index in postfix array when emitted
+};
+
+struct ekey_t {
+  op_t op;
+  int type_id;
+  int imm;
+  const expr_t *lhs;
+  const expr_t *rhs;
+
+  bool operator==(const ekey_t &rhs) const {
+    return op == rhs.op && type_id == rhs.type_id && imm == rhs.imm &&
+           lhs == rhs.lhs && this->rhs == rhs.rhs;
+  }
+};
+
+struct ekey_hash_t {
+  std::size_t operator()(const ekey_t &k) const {
+    std::size_t h = std::hash<int>{}(int(k.op));
+    auto mix = [&h](std::size_t v) {
+      h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+    };
+    mix(std::hash<int>{}(k.type_id));
+    mix(std::hash<int>{}(k.imm));
+    mix(std::hash<const expr_t *>{}(k.lhs));
+    mix(std::hash<const expr_t *>{}(k.rhs));
+    return h;
+  }
+};
+
+} // namespace
+
+const char *op_name(op_t op) { return op_names[int(op)]; }
+
+bool is_wrapping(op_t op) {
+  return op == op_t::NEG || op == op_t::ADD || op == op_t::SUB ||
+         op == op_t::MUL;
+}
+
+// builder state, reused for all functions
+struct exprir_t::func_builder {
+  const cfg::config &cf;
+  const tg::typegraph_t &tg;
+  ms::metanode_t meta;
+
+  utils::arena_t exprs;
+  std::unordered_map<ekey_t, const expr_t *, ekey_hash_t> table;
+  int nextid = 0;
+
+  const li::node_locs_t *locs = nullptr;
+  std::vector<int> scalar_uses;
+
+  std::vector<enode_t> post;
+  std::vector<assign_t> assigns;
+  std::vector<node_exprs_t> nodes;
+
+  func_builder(const cfg::config &c, const tg::typegraph_t &t)
+      : cf(c), tg(t) {}
+
+  bool is_scalar(int tid) const { return tg.vertex_from(tid).is_scalar(); }
+
+  bool is_float(int tid) const {
+    auto vpt = tg.vertex_from(tid);
+    return vpt.is_scalar() &&
+           std::get<tg::scalar_t>(vpt.type).sdesc->is_float;
+  }
+
+  // hash-consed node
+  const expr_t *intern(op_t op, int tid, int imm, const expr_t *lhs = nullptr,
+                       const expr_t *rhs = nullptr) {
+    if (is_commutative(op) && lhs->id > rhs->id)
+      std::swap(lhs, rhs);
+    auto [it, inserted] = table.try_emplace({op, tid, imm, lhs, rhs});
+    if (inserted)
+      it->second =
+          exprs.create<expr_t>(expr_t{op, tid, imm, lhs, rhs, nextid++});
+    return it->second;
+  }
+
+  void start_node(const li::node_locs_t &nl) {
+    locs = &nl;
+    table.clear();
+    post.clear();
+    assigns.clear();
+    scalar_uses.clear();
+    for (int u = 0; u != nl.nuses; ++u)
+      if (is_scalar(nl.uses[u].type_id))
+        scalar_uses.push_back(u);
+  }
+
+  const expr_t *random_use() {
+    int u = scalar_uses[cf.rand_positive() % scalar_uses.size()];
+    return intern(op_t::LOC, locs->uses[u].type_id, u);
+  }
+
+  const expr_t *leaf(int tid) {
+    if (scalar_uses.empty() || cfg::get(cf, EI::CONSTPROB))
+      return intern(op_t::CONST, tid, cf.rand_positive() % 16);
+    const expr_t *e = random_use();
+    if (e->type_id != tid)
+      e = intern(op_t::CAST, tid, 0, e);
+    return e;
+  }
+
+  const expr_t *gen(int tid, int depth) {
+    if (depth == 0 || cfg::get(cf, EI::LEAF))
+      return leaf(tid);
+
+    // no bit operations on floats and no negation without signed types
+    constexpr op_t ops[] = {op_t::ADD, op_t::SUB, op_t::MUL, op_t::AND,
+                            op_t::OR,  op_t::XOR, op_t::NEG};
+    static_assert(std::size(ops) == EIO_MAX);
+    op_t op = ops[cfg::get(cf, EI::OPPROB)];
+    if (is_float(tid) && (op == op_t::AND || op == op_t::OR))
+      op = op_t::ADD;
+    if (is_float(tid) && op == op_t::XOR)
+      op = op_t::MUL;
+    if (op == op_t::NEG && !meta.usesigned)
+      op = op_t::SUB;
+
+    if (op == op_t::NEG)
+      return intern(op, tid, 0, gen(tid, depth - 1));
+    const expr_t *lhs = gen(tid, depth - 1);
+    const expr_t *rhs = gen(tid, depth - 1);
+    return intern(op, tid, 0, lhs, rhs);
+  }
+
+  // every distinct subtree once, operands first
+  int emit(const expr_t *e) {
+    if (e->post != -1)
+      return e->post;
+    enode_t en{e->op, e->type_id, e->imm};
+    if (e->lhs != nullptr)
+      en.a = emit(e->lhs);
+    if (e->rhs != nullptr)
+      en.b = emit(e->rhs);
+    e->post = post.size();
+    post.push_back(en);
+    return e->post;
+  }
+};
+
+//------------------------------------------------------------------------------
+//
+// ExprIR public interface
+//
+//------------------------------------------------------------------------------
+
+exprir_t::exprir_t(cfg::config &&cf, std::shared_ptr<tg::typegraph_t> tgraph,
+                   std::shared_ptr<cg::callgraph_t> cgraph,
+                   std::shared_ptr<li::locir_t> locir)
+    : config_(std::move(cf)), tgraph_(tgraph), cgraph_(cgraph),
+      locir_(locir) {
+  if (!config_.quiet())
+    dbgs() << "Creating exprir\n";
+
+  int nfuncs = locir_->nfuncs();
+  funcs_.resize(nfuncs);
+
+  func_builder fb{config_, *tgraph_};
+  for (int f = 0; f != nfuncs; ++f) {
+    build_function(f, fb);
+    fb.exprs.release();
+  }
+}
+
+void exprir_t::print_expr(std::ostream &os, const node_exprs_t &ne,
+                          int n) const {
+  const enode_t &en = ne.exprs[n];
+  switch (en.op) {
+  case op_t::LOC:
+    locir_->print_loc(os, ne.locs->uses[en.a]);
+    break;
+  case op_t::CONST:
+    os << en.a;
+    break;
+  case op_t::CAST:
+    os << "(" << tgraph_->short_name(en.type_id) << ")";
+    print_expr(os, ne, en.a);
+    break;
+  case op_t::NEG:
+    os << "-(";
+    print_expr(os, ne, en.a);
+    os << ")";
+    break;
+  case op_t::ADD:
+  case op_t::SUB:
+  case op_t::MUL:
+  case op_t::AND:
+  case op_t::OR:
+  case op_t::XOR:
+    os << "(";
+    print_expr(os, ne, en.a);
+    os << " " << op_name(en.op) << " ";
+    print_expr(os, ne, en.b);
+    os << ")";
+    break;
+  default:
+    throw std::runtime_error("Unknown expression operation");
+  }
+}
+
+void exprir_t::dump(std::ostream &os) const {
+  const auto &cn = locir_->controlgraph();
+
+  os << "ExprIR consists of " << nfuncs() << " functions, " << memory_used()
+     << " bytes\n";
+  for (int f = 0; f != nfuncs(); ++f) {
+    os << "<FOO" << f << ">:" << std::endl;
+    for (auto *ne = begin(f); ne != end(f); ++ne) {
+      auto vp = cn.from_vertex(f, ne->locs->v);
+      os << "#" << ne->locs->v << " " << vp << std::endl;
+      for (int i = 0; i != ne->nassigns; ++i) {
+        const assign_t &a = ne->assigns[i];
+        os << "  ";
+        if (a.def == -1)
+          os << "COND";
+        else
+          locir_->print_loc(os, ne->locs->defs[a.def]);
+        os << " = ";
+        print_expr(os, *ne, a.root);
+        os << std::endl;
+      }
+    }
+    os << "---" << std::endl << std::endl;
+  }
+}
+
+//------------------------------------------------------------------------------
+//
+// Construction helpers
+//
+//------------------------------------------------------------------------------
+
+void exprir_t::build_function(int nfunc, func_builder &fb) {
+  const auto &cn = locir_->controlgraph();
+  fb.meta = cgraph_->vertex_from(nfunc).metainfo;
+  fb.nodes.clear();
+
+  for (auto *nl = locir_->begin(nfunc); nl != locir_->end(nfunc); ++nl) {
+    auto cat = cn.from_vertex(nfunc, nl->v).cat();
+    if (cat != cn::category_t::BLOCK && cat != cn::category_t::ACCESS &&
+        cat != cn::category_t::BRANCHING)
+      continue;
+
+    fb.start_node(*nl);
+    int depth = cfg::get(config_, EI::DEPTH);
+
+    if (cat == cn::category_t::BRANCHING) {
+      if (fb.scalar_uses.empty())
+        continue;
+      int tid = fb.random_use()->type_id;
+      fb.assigns.push_back({-1, fb.emit(fb.gen(tid, depth))});
+    }
+
+    // non-scalar def may only be copied from same typed use
+    for (int d = 0; d != nl->ndefs; ++d) {
+      int tid = nl->defs[d].type_id;
+      if (fb.is_scalar(tid)) {
+        fb.assigns.push_back({d, fb.emit(fb.gen(tid, depth))});
+        continue;
+      }
+      for (int u = 0; u != nl->nuses; ++u)
+        if (nl->uses[u].type_id == tid) {
+          fb.assigns.push_back({d, fb.emit(fb.intern(op_t::LOC, tid, u))});
+          break;
+        }
+    }
+
+    if (fb.assigns.empty())
+      continue;
+
+    node_exprs_t ne;
+    ne.locs = nl;
+    ne.nexprs = fb.post.size();
+    ne.nassigns = fb.assigns.size();
+    ne.exprs = arena_.copy(fb.post.data(), fb.post.size());
+    ne.assigns = arena_.copy(fb.assigns.data(), fb.assigns.size());
+    fb.nodes.push_back(ne);
+  }
+
+  funcs_[nfunc].nodes = arena_.copy(fb.nodes.data(), fb.nodes.size());
+  funcs_[nfunc].nnodes = fb.nodes.size();
+}
+
+} // namespace ei
+
+//------------------------------------------------------------------------------
+//
+// Task system support
+//
+//------------------------------------------------------------------------------
+
+std::shared_ptr<ei::exprir_t>
+exprir_create(int seed, const cfg::config &cf,
+              std::shared_ptr<tg::typegraph_t> sptg,
+              std::shared_ptr<cg::callgraph_t> spcg,
+              std::shared_ptr<li::locir_t> spli) {
+  try {
+    cfg::config newcf(seed, cf.quiet(), cf.dumps(), cf.cbegin(), cf.cend());
+    return std::make_shared<ei::exprir_t>(std::move(newcf), sptg, spcg, spli);
+  } catch (std::runtime_error &e) {
+    std::cerr << "ExprIR construction problem: " << e.what() << std::endl;
+    throw;
+  }
+}
+
+void exprir_dump(std::shared_ptr<ei::exprir_t> pe, std::ostream &os) {
+  pe->dump(os);
+}
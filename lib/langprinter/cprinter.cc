@@ -0,0 +1,726 @@
+//------------------------------------------------------------------------------
+//
+// C printer: final program from ExprIR
+//
+// Function is printed by walking its control tree, node expressions and
+// locations are found by vertex. Node mapping:
+//
+// BLOCK     -- assignments
+// ACCESS    -- { index assignments; child }
+// CALL      -- [def =] foo(args), indirect one through function pointer,
+//              args are uses of same type or zeros. Call inside recursive
+//              SCC is guarded by global recursion budget
+// LOOP      -- for (int lN = start; lN < stop; lN += step) { ... }
+// IF        -- if (cond) { ... } else if (cond) { ... } else { ... }
+// SWITCH    -- switch (cond % ncases) { case 0: { ... break; } ... }
+// REGION    -- conditional gotos into labeled branches, so region have
+//              several entries but no back edges
+// BREAK     -- break, continue or return (if allowed by nesting)
+//
+//------------------------------------------------------------------------------
+//
+// This file is licensed after LGPL v3
+// Look at: https://www.gnu.org/licenses/lgpl-3.0.en.html for details
+//
+//------------------------------------------------------------------------------
+
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/stream.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "callgraph/callgraph.h"
+#include "coelacanth/dbgstream.h"
+#include "coelacanth/tasksystem.h"
+#include "controlgraph/controlgraph.h"
+#include "cprinter.h"
+#include "typegraph/typegraph.h"
+#include "utils/indent_ostream.h"
+#include "varassign/varassign.h"
+
+namespace lp {
+
+using utils::decrease_indent;
+using utils::increase_indent;
+
+// indent is always increased before newline, so next line gets it
+constexpr int INDENT_SPACES = 2;
+
+// calls inside recursive SCC share global budget, counter is never
+// decreased, so recursion can not blow up even if call is in loop
+constexpr int RECURSION_BUDGET = 64;
+constexpr const char *RECURSION_COUNTER = "rec_calls";
+
+//------------------------------------------------------------------------------
+//
+// Function printer
+//
+//------------------------------------------------------------------------------
+
+struct cprinter_t::func_printer {
+  const cprinter_t &p;
+  const tg::typegraph_t &types;
+  const va::varassign_t &vars;
+  const cn::controlgraph_t &ctl;
+  std::ostream &os;
+  int nfunc;
+
+  // node locations and expressions by vertex
+  std::vector<const li::node_locs_t *> locs;
+  std::vector<const ei::node_exprs_t *> exprs;
+
+  func_printer(const cprinter_t &pr, std::ostream &o, int f)
+      : p(pr), types(*pr.tgraph_), vars(*pr.vassign_),
+        ctl(pr.exprir_->locir().controlgraph()), os(o), nfunc(f) {
+    const auto &li = p.exprir_->locir();
+    for (auto *nl = li.begin(f); nl != li.end(f); ++nl) {
+      if (nl->v >= int(locs.size()))
+        locs.resize(nl->v + 1);
+      locs[nl->v] = nl;
+    }
+    exprs.resize(locs.size());
+    for (auto *ne = p.exprir_->begin(f); ne != p.exprir_->end(f); ++ne)
+      exprs[ne->locs->v] = ne;
+  }
+
+  const li::node_locs_t *locs_of(cn::vertex_t v) const {
+    return v < int(locs.size()) ? locs[v] : nullptr;
+  }
+
+  const ei::node_exprs_t *exprs_of(cn::vertex_t v) const {
+    return v < int(exprs.size()) ? exprs[v] : nullptr;
+  }
+
+  int child_type(int tid, int n) const {
+    return (*(types.begin_childs(tid) + n)).first;
+  }
+
+  int nitems(int tid) const {
+    return std::get<tg::array_t>(types.vertex_from(tid).type).nitems;
+  }
+
+  void type(int tid) { os << types.short_name(tid); }
+  void name(int vid) { os << vars.get_name(vid); }
+
+  // (unsigned)(i5) % 10 or (unsigned)(p3[(unsigned)(i5) % 10]) % 10
+  void index(const li::step_t &st, int n) {
+    if (st.arg == -1) {
+      os << "0";
+      return;
+    }
+    os << "(unsigned)(";
+    if (st.perm != -1) {
+      name(st.perm);
+      os << "[(unsigned)(";
+      name(st.arg);
+      os << ") % " << n << "]";
+    } else {
+      name(st.arg);
+    }
+    os << ") % " << n;
+  }
+
+  // pointee of every pointer is fixed variable (see locir), so dereference
+  // is printed as that variable and path before it is dropped:
+  // v4.f0->f2 is p7.f2. Pointers themselves are never dereferenced, so they
+  // need not point anywhere
+  void loc(const li::loc_t &l) {
+    const li::step_t *first = l.end();
+    while (first != l.begin() && first[-1].kind != li::step_kind_t::DEREF)
+      --first;
+    int vid = (first == l.begin()) ? l.var : first[-1].arg;
+    name(vid);
+
+    int tid = vars.at(vid).type_id;
+    for (auto *st = first; st != l.end(); ++st) {
+      switch (st->kind) {
+      case li::step_kind_t::FIELD:
+        os << ".f" << st->arg;
+        tid = child_type(tid, st->arg);
+        break;
+      case li::step_kind_t::INDEX:
+        os << "[";
+        index(*st, nitems(tid));
+        os << "]";
+        tid = child_type(tid, 0);
+        break;
+      default:
+        throw std::runtime_error("Unknown location step");
+      }
+    }
+    assert(tid == l.type_id);
+  }
+
+  bool is_float(int tid) const {
+    return std::get<tg::scalar_t>(types.vertex_from(tid).type).sdesc->is_float;
+  }
+
+  void expr(const ei::node_exprs_t &ne, int n) {
+    const ei::enode_t &en = ne.exprs[n];
+    if (ei::is_wrapping(en.op) && !is_float(en.type_id)) {
+      auto lhs = [&] {
+        if (en.op == ei::op_t::NEG)
+          os << "0";
+        else
+          expr(ne, en.a);
+      };
+      auto rhs = [&] { expr(ne, en.op == ei::op_t::NEG ? en.a : en.b); };
+      print_wrapping(os, types.short_name(en.type_id), ei::op_name(en.op), lhs,
+                     rhs);
+      return;
+    }
+
+    switch (en.op) {
+    case ei::op_t::LOC:
+      loc(ne.locs->uses[en.a]);
+      break;
+    case ei::op_t::CONST:
+      os << en.a;
+      break;
+    case ei::op_t::CAST: {
+      // out of range float to integer conversion is UB, ftoi is not
+      bool ftoi = is_float(ne.exprs[en.a].type_id) && !is_float(en.type_id);
+      os << "((";
+      type(en.type_id);
+      os << (ftoi ? ")ftoi(" : ")");
+      expr(ne, en.a);
+      os << (ftoi ? "))" : ")");
+      break;
+    }
+    case ei::op_t::NEG:
+      os << "(-";
+      expr(ne, en.a);
+      os << ")";
+      break;
+    case ei::op_t::ADD:
+    case ei::op_t::SUB:
+    case ei::op_t::MUL:
+    case ei::op_t::AND:
+    case ei::op_t::OR:
+    case ei::op_t::XOR:
+      os << "(";
+      expr(ne, en.a);
+      os << " " << ei::op_name(en.op) << " ";
+      expr(ne, en.b);
+      os << ")";
+      break;
+    default:
+      throw std::runtime_error("Unknown expression operation");
+    }
+  }
+
+  // root of branching condition or -1 if it have none
+  int cond_root(cn::vertex_t v) const {
+    if (auto *ne = exprs_of(v))
+      for (int i = 0; i != ne->nassigns; ++i)
+        if (ne->assigns[i].def == -1)
+          return ne->assigns[i].root;
+    return -1;
+  }
+
+  void cond(cn::vertex_t v) {
+    int root = cond_root(v);
+    if (root == -1)
+      os << "1";
+    else
+      expr(*exprs_of(v), root);
+  }
+
+  // integer condition selects case modulo number of cases, float one can
+  // only select between first two
+  void selector(cn::vertex_t v, int ncases) {
+    int root = cond_root(v);
+    if (root == -1) {
+      os << "0";
+      return;
+    }
+    const ei::node_exprs_t &ne = *exprs_of(v);
+    if (is_float(ne.exprs[root].type_id)) {
+      os << "(int)(";
+      expr(ne, root);
+      os << " != 0)";
+      return;
+    }
+    os << "(unsigned long long)(";
+    expr(ne, root);
+    os << ") % " << ncases;
+  }
+
+  void assigns(cn::vertex_t v) {
+    auto *ne = exprs_of(v);
+    if (ne == nullptr)
+      return;
+    for (int i = 0; i != ne->nassigns; ++i) {
+      const ei::assign_t &a = ne->assigns[i];
+      if (a.def == -1)
+        continue;
+      const li::loc_t &def = ne->locs->defs[a.def];
+      // arrays are not assignable, their only expression is same typed use
+      if (types.vertex_from(def.type_id).is_array()) {
+        os << "memcpy(&";
+        loc(def);
+        os << ", &";
+        expr(*ne, a.root);
+        os << ", sizeof(";
+        type(def.type_id);
+        os << "));\n";
+        continue;
+      }
+      loc(def);
+      os << " = ";
+      expr(*ne, a.root);
+      os << ";\n";
+    }
+  }
+
+  void zero(int tid) {
+    os << "(";
+    type(tid);
+    os << "){0}";
+  }
+
+  void ret() {
+    int rettype = p.cgraph_->vertex_from(nfunc).rettype;
+    if (rettype == -1) {
+      os << "return;\n";
+      return;
+    }
+    os << "return ";
+    zero(rettype);
+    os << ";\n";
+  }
+
+  void childs(cn::vertex_t v) {
+    for (auto it = ctl.begin_childs(nfunc, v); it != ctl.end_childs(nfunc, v);
+         ++it)
+      node(*it);
+  }
+
+  // childs in own block
+  void body(cn::vertex_t v) {
+    os << "{" << increase_indent << "\n";
+    childs(v);
+    os << decrease_indent << "}";
+  }
+
+  void call(cn::vertex_t v, const cn::call_t &c) {
+    auto callee = p.cgraph_->vertex_from(c.nfunc);
+    auto *nl = locs_of(v);
+    std::vector<bool> taken(nl ? nl->nuses : 0);
+
+    // callee in same SCC may (indirectly) call us back
+    bool guarded = p.cgraph_->scc_of(c.nfunc) == p.cgraph_->scc_of(nfunc);
+    if (guarded)
+      os << "if (" << RECURSION_COUNTER << " < " << RECURSION_BUDGET << ") {"
+         << increase_indent << "\n"
+         << RECURSION_COUNTER << " += 1;\n";
+
+    bool indirect = (c.type == cn::call_type_t::INDIRECT);
+    if (indirect) {
+      os << "{" << increase_indent << "\n";
+      p.print_pointer(os, c.nfunc, "fp");
+      os << " = " << p.cgraph_->func_name(c.nfunc) << ";\n";
+    }
+
+    if (callee.rettype != -1 && nl && nl->ndefs > 0 &&
+        nl->defs[0].type_id == callee.rettype) {
+      loc(nl->defs[0]);
+      os << " = ";
+    }
+
+    if (indirect)
+      os << "fp(";
+    else
+      os << p.cgraph_->func_name(c.nfunc) << "(";
+
+    for (int i = 0, ie = callee.argtypes.size(); i != ie; ++i) {
+      int tid = callee.argtypes[i];
+      if (i != 0)
+        os << ", ";
+      int u = 0;
+      while (u != int(taken.size()) && (taken[u] || nl->uses[u].type_id != tid))
+        ++u;
+      if (u != int(taken.size())) {
+        taken[u] = true;
+        loc(nl->uses[u]);
+      } else {
+        zero(tid);
+      }
+    }
+    os << ");\n";
+
+    if (indirect)
+      os << decrease_indent << "}\n";
+
+    if (guarded)
+      os << decrease_indent << "}\n";
+  }
+
+  void node(cn::vertex_t v) {
+    auto vp = ctl.from_vertex(nfunc, v);
+    switch (vp.cat()) {
+    case cn::category_t::BLOCK:
+      assigns(v);
+      break;
+    case cn::category_t::ACCESS:
+      os << "{" << increase_indent << "\n";
+      assigns(v);
+      childs(v);
+      os << decrease_indent << "}\n";
+      break;
+    case cn::category_t::CALL:
+      call(v, std::get<cn::call_t>(vp.type()));
+      break;
+    case cn::category_t::LOOP: {
+      auto l = std::get<cn::loop_t>(vp.type());
+      int d = vp.nesting().loop_depth;
+      os << "for (int l" << d << " = " << l.start << "; l" << d << " < "
+         << l.stop << "; l" << d << " += " << l.step << ") ";
+      body(v);
+      os << "\n";
+      break;
+    }
+    case cn::category_t::IF: {
+      int n =
+          std::distance(ctl.begin_childs(nfunc, v), ctl.end_childs(nfunc, v));
+      int i = 0;
+      for (auto it = ctl.begin_childs(nfunc, v); it != ctl.end_childs(nfunc, v);
+           ++it, ++i) {
+        if (i != 0)
+          os << " else ";
+        if (i == 0 || i != n - 1) {
+          os << "if (";
+          cond(*it);
+          os << ") ";
+        }
+        body(*it);
+      }
+      os << "\n";
+      break;
+    }
+    case cn::category_t::SWITCH: {
+      auto first = ctl.begin_childs(nfunc, v);
+      int n = std::distance(first, ctl.end_childs(nfunc, v));
+      os << "switch (";
+      if (n != 0)
+        selector(*first, n);
+      else
+        os << "0";
+      os << ") {\n";
+      int i = 0;
+      for (auto it = first; it != ctl.end_childs(nfunc, v); ++it, ++i) {
+        os << "case " << i << ": {" << increase_indent << "\n";
+        childs(*it);
+        os << "break;\n" << decrease_indent << "}\n";
+      }
+      os << "}\n";
+      break;
+    }
+    case cn::category_t::REGION: {
+      int i = 0;
+      for (auto it = ctl.begin_childs(nfunc, v); it != ctl.end_childs(nfunc, v);
+           ++it, ++i)
+        if (i != 0) {
+          os << "if (";
+          cond(*it);
+          os << ") goto R" << v << "_" << i << ";\n";
+        }
+      i = 0;
+      for (auto it = ctl.begin_childs(nfunc, v); it != ctl.end_childs(nfunc, v);
+           ++it, ++i) {
+        os << "R" << v << "_" << i << ":;\n";
+        body(*it);
+        os << "\n";
+      }
+      break;
+    }
+    case cn::category_t::BREAK: {
+      const auto &nest = vp.nesting();
+      bool in_loop = nest.inside(cn::category_t::LOOP);
+      bool in_switch = nest.inside(cn::category_t::SWITCH);
+      switch (std::get<cn::break_t>(vp.type()).btp) {
+      case cn::break_type_t::CONTINUE:
+        os << (in_loop ? "continue;\n" : ";\n");
+        break;
+      case cn::break_type_t::BREAK:
+        os << ((in_loop || in_switch) ? "break;\n" : ";\n");
+        break;
+      default:
+        ret();
+        break;
+      }
+      break;
+    }
+    default:
+      childs(v);
+      break;
+    }
+  }
+};
+
+//------------------------------------------------------------------------------
+//
+// C printer public interface
+//
+//------------------------------------------------------------------------------
+
+cprinter_t::cprinter_t(std::shared_ptr<tg::typegraph_t> tgraph,
+                       std::shared_ptr<cg::callgraph_t> cgraph,
+                       std::shared_ptr<va::varassign_t> vassign,
+                       std::shared_ptr<ei::exprir_t> exprir)
+    : tgraph_(tgraph), cgraph_(cgraph), vassign_(vassign), exprir_(exprir) {}
+
+std::size_t cprinter_t::print(std::ostream &os) const {
+  namespace io = boost::iostreams;
+  int nfuncs = cgraph_->nfuncs();
+
+  // two last buffers are header and main
+  std::vector<std::string> bufs(nfuncs + 2);
+  parallel_for(nfuncs + 2, [this, nfuncs, &bufs](int n) {
+    io::stream<io::back_insert_device<std::string>> sink{bufs[n]};
+    utils::indent_ostream_t ios{sink, INDENT_SPACES};
+    if (n == nfuncs)
+      print_header(ios);
+    else if (n == nfuncs + 1)
+      print_main(ios);
+    else
+      print_function(ios, n);
+    ios.flush();
+    sink.flush();
+  });
+
+  std::size_t nbytes = 0;
+  auto write = [&os, &nbytes](const std::string &s) {
+    os.write(s.data(), s.size());
+    nbytes += s.size();
+  };
+
+  write(bufs[nfuncs]);
+  for (int m = 0; m != cgraph_->nmodules(); ++m)
+    for (auto it = cgraph_->module_begin(m); it != cgraph_->module_end(m);
+         ++it)
+      write(bufs[*it]);
+  write(bufs[nfuncs + 1]);
+
+  return nbytes;
+}
+
+//------------------------------------------------------------------------------
+//
+// Printing helpers
+//
+//------------------------------------------------------------------------------
+
+void cprinter_t::print_header(std::ostream &os) const {
+  const auto &types = *tgraph_;
+  const auto &vars = *vassign_;
+  int ntypes = types.ntypes();
+
+  enum { NEW = 0, OPEN, DONE };
+  std::vector<char> state(ntypes, NEW);
+
+  os << "#include <string.h>\n\n";
+  os << "static long long ftoi(double x) {\n"
+     << "  return (x > -1e18 && x < 1e18) ? (long long)x : 0;\n"
+     << "}\n\n";
+
+  for (int tid = 0; tid != ntypes; ++tid) {
+    auto vpt = types.vertex_from(tid);
+    if (vpt.is_scalar()) {
+      os << "typedef " << std::get<tg::scalar_t>(vpt.type).sdesc->name << " "
+         << types.short_name(tid) << ";\n";
+      state[tid] = DONE;
+    }
+  }
+
+  for (int tid = 0; tid != ntypes; ++tid)
+    if (types.vertex_from(tid).is_struct())
+      os << "typedef struct " << types.short_name(tid) << " "
+         << types.short_name(tid) << ";\n";
+
+  for (int tid = 0; tid != ntypes; ++tid)
+    print_type(os, tid, state);
+  os << "\n";
+
+  for (int vid = 0; vid != vars.nvars() && vars.is_global(vid); ++vid)
+    os << types.short_name(vars.at(vid).type_id) << " " << vars.get_name(vid)
+       << ";\n";
+  os << "int " << RECURSION_COUNTER << ";\n\n";
+
+  for (int f = 0; f != cgraph_->nfuncs(); ++f) {
+    print_signature(os, f);
+    os << ";\n";
+  }
+  os << "\n";
+}
+
+// typedef of tid after all its parts. Returns false if it can not be done
+// now, because part is being printed (only possible through pointer)
+bool cprinter_t::print_type(std::ostream &os, int tid,
+                            std::vector<char> &state) const {
+  enum { NEW = 0, OPEN, DONE };
+  const auto &types = *tgraph_;
+  if (state[tid] == DONE)
+    return true;
+  if (state[tid] == OPEN)
+    return false;
+  state[tid] = OPEN;
+
+  auto vpt = types.vertex_from(tid);
+  auto name = types.short_name(tid);
+  switch (vpt.cat) {
+  case tg::category_t::ARRAY: {
+    int elem = (*types.begin_childs(tid)).first;
+    if (!print_type(os, elem, state)) {
+      state[tid] = NEW;
+      return false;
+    }
+    os << "typedef " << types.short_name(elem) << " " << name << "["
+       << std::get<tg::array_t>(vpt.type).nitems << "];\n";
+    break;
+  }
+  case tg::category_t::POINTER: {
+    // structs are forward declared, incomplete pointee degrades to void
+    auto pt = types.get_pointee(tid);
+    bool ok = pt.is_struct() || print_type(os, pt.id, state);
+    os << "typedef " << (ok ? types.short_name(pt.id) : "void") << " *" << name
+       << ";\n";
+    break;
+  }
+  case tg::category_t::STRUCT: {
+    for (auto it = types.begin_childs(tid); it != types.end_childs(tid); ++it) {
+      bool ok = print_type(os, (*it).first, state);
+      assert(ok && "Cycle without pointer in typegraph");
+      (void)ok;
+    }
+
+    // bitfields are in order of fields, width is limited by type
+    const auto &bfs = std::get<tg::struct_t>(vpt.type).bitfields_;
+    auto bf = bfs.begin();
+    os << "struct " << name << " {\n";
+    int n = 0;
+    for (auto it = types.begin_childs(tid); it != types.end_childs(tid);
+         ++it, ++n) {
+      int ftid = (*it).first;
+      os << "  " << types.short_name(ftid) << " f" << n;
+      if (bf != bfs.end() && bf->first == ftid) {
+        auto *sd = std::get<tg::scalar_t>(types.vertex_from(ftid).type).sdesc;
+        if (!sd->is_float)
+          os << " : " << std::min(bf->second, sd->size);
+        ++bf;
+      }
+      os << ";\n";
+    }
+    // empty structure is not C, never accessed anyway
+    if (n == 0)
+      os << "  char f0;\n";
+    os << "};\n";
+    break;
+  }
+  default:
+    break;
+  }
+
+  state[tid] = DONE;
+  return true;
+}
+
+// T3 foo5(T1 v7, S4 v8)
+void cprinter_t::print_signature(std::ostream &os, int nfunc) const {
+  const auto &vars = *vassign_;
+  auto vp = cgraph_->vertex_from(nfunc);
+  if (vp.rettype == -1)
+    os << "void";
+  else
+    os << tgraph_->short_name(vp.rettype);
+  os << " " << cgraph_->func_name(nfunc) << "(";
+
+  bool first = true;
+  for (auto it = vars.fv_begin(nfunc); it != vars.fv_end(nfunc); ++it)
+    if (vars.is_argument(nfunc, *it)) {
+      os << (first ? "" : ", ") << tgraph_->short_name(vars.at(*it).type_id)
+         << " " << vars.get_name(*it);
+      first = false;
+    }
+  if (first)
+    os << "void";
+  os << ")";
+}
+
+// T3 (*name)(T1, S4)
+void cprinter_t::print_pointer(std::ostream &os, int nfunc,
+                               const char *name) const {
+  auto vp = cgraph_->vertex_from(nfunc);
+  if (vp.rettype == -1)
+    os << "void";
+  else
+    os << tgraph_->short_name(vp.rettype);
+  os << " (*" << name << ")(";
+  for (auto it = vp.argtypes.begin(); it != vp.argtypes.end(); ++it)
+    os << (it == vp.argtypes.begin() ? "" : ", ")
+       << tgraph_->short_name(*it);
+  if (vp.argtypes.empty())
+    os << "void";
+  os << ")";
+}
+
+// main calls main function of callgraph with zero arguments
+void cprinter_t::print_main(std::ostream &os) const {
+  int mainf = cgraph_->main_func();
+  const auto &argtypes = cgraph_->vertex_from(mainf).argtypes;
+  os << "int main(void) {" << increase_indent << "\n";
+  os << cgraph_->func_name(mainf) << "(";
+  for (auto it = argtypes.begin(); it != argtypes.end(); ++it)
+    os << (it == argtypes.begin() ? "" : ", ") << "("
+       << tgraph_->short_name(*it) << "){0}";
+  os << ");\nreturn 0;\n" << decrease_indent << "}\n";
+}
+
+void cprinter_t::print_function(std::ostream &os, int nfunc) const {
+  const auto &vars = *vassign_;
+  func_printer fp{*this, os, nfunc};
+
+  print_signature(os, nfunc);
+  os << " {" << increase_indent << "\n";
+
+  for (auto it = vars.fv_begin(nfunc); it != vars.fv_end(nfunc); ++it)
+    if (!vars.is_global(*it) && !vars.is_argument(nfunc, *it))
+      os << tgraph_->short_name(vars.at(*it).type_id) << " "
+         << vars.get_name(*it) << " = {0};\n";
+
+  const auto &ctl = exprir_->locir().controlgraph();
+  for (auto it = ctl.begin(nfunc); it != ctl.end(nfunc); ++it)
+    fp.node(*it);
+
+  if (cgraph_->vertex_from(nfunc).rettype != -1)
+    fp.ret();
+  os << decrease_indent << "}\n\n";
+}
+
+} // namespace lp
+
+//------------------------------------------------------------------------------
+//
+// Task system support
+//
+//------------------------------------------------------------------------------
+
+std::size_t langprinter_print(std::shared_ptr<tg::typegraph_t> sptg,
+                              std::shared_ptr<cg::callgraph_t> spcg,
+                              std::shared_ptr<va::varassign_t> spva,
+                              std::shared_ptr<ei::exprir_t> spei,
+                              std::string fname) {
+  try {
+    std::ofstream of(fname);
+    return lp::cprinter_t(sptg, spcg, spva, spei).print(of);
+  } catch (std::runtime_error &e) {
+    std::cerr << "Printing problem: " << e.what() << std::endl;
+    throw;
+  }
+}
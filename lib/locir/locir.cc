@@ -0,0 +1,256 @@
+//------------------------------------------------------------------------------
+//
+// LocIR: concrete locations for control graph defs and uses
+//
+// Function by function, nodes are walked in preorder, every def and use
+// variable gets location. Path goes from variable type down:
+// * struct gives random field
+// * array gives index: accessor of current variable if it have any, else
+//   free index of function. Own arrays of variable may be permuted
+// * pointer with known pointee may be followed (LI::DEREF), then path
+//   continues inside pointee variable
+// Walk stops at scalar or at pointer which is not followed.
+//
+// Paths and locations are collected in reusable scratch vectors and then
+// copied into arena, so arena holds exactly final IR
+//
+//------------------------------------------------------------------------------
+//
+// This file is licensed after LGPL v3
+// Look at: https://www.gnu.org/licenses/lgpl-3.0.en.html for details
+//
+//------------------------------------------------------------------------------
+
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "coelacanth/dbgstream.h"
+#include "coelacanth/tasksystem.h"
+#include "controlgraph/controlgraph.h"
+#include "locir.h"
+#include "typegraph/typegraph.h"
+#include "varassign/varassign.h"
+
+namespace li {
+
+// reusable per-function buffers
+struct locir_t::func_scratch {
+  std::vector<int> free_idxs;
+  std::vector<step_t> steps;
+  std::vector<loc_t> locs;
+  std::vector<node_locs_t> nodes;
+  std::vector<cn::vertex_t> stack;
+};
+
+//------------------------------------------------------------------------------
+//
+// LocIR public interface
+//
+//------------------------------------------------------------------------------
+
+locir_t::locir_t(cfg::config &&cf, std::shared_ptr<tg::typegraph_t> tgraph,
+                 std::shared_ptr<va::varassign_t> vassign,
+                 std::shared_ptr<cn::controlgraph_t> contgraph)
+    : config_(std::move(cf)), tgraph_(tgraph), vassign_(vassign),
+      contgraph_(contgraph) {
+  if (!config_.quiet())
+    dbgs() << "Creating locir\n";
+
+  int nfuncs = contgraph_->nfuncs();
+  funcs_.resize(nfuncs);
+
+  func_scratch fs;
+  for (int f = 0; f != nfuncs; ++f)
+    build_function(f, fs);
+}
+
+// v3.f1[p7[i5]], dereference wraps everything before it: (*v4.f0).f2
+void locir_t::print_loc(std::ostream &os, const loc_t &l) const {
+  std::string s{vassign_->get_name(l.var)};
+  for (auto &st : l) {
+    switch (st.kind) {
+    case step_kind_t::FIELD:
+      s += ".f";
+      s += std::to_string(st.arg);
+      break;
+    case step_kind_t::INDEX: {
+      std::string idx =
+          (st.arg == -1) ? "0" : std::string{vassign_->get_name(st.arg)};
+      if (st.perm != -1)
+        idx = std::string{vassign_->get_name(st.perm)} + "[" + idx + "]";
+      s += "[" + idx + "]";
+      break;
+    }
+    case step_kind_t::DEREF:
+      s = "(*" + s + ")";
+      break;
+    default:
+      throw std::runtime_error("Unknown location step");
+    }
+  }
+  os << s;
+}
+
+void locir_t::dump(std::ostream &os) const {
+  constexpr const char *storage_names[] = {"global", "local", "arg"};
+
+  os << "LocIR consists of " << nfuncs() << " functions, " << memory_used()
+     << " bytes\n";
+  for (int f = 0; f != nfuncs(); ++f) {
+    os << "<FOO" << f << ">:" << std::endl;
+    for (auto *n = begin(f); n != end(f); ++n) {
+      os << "#" << n->v << " "
+         << contgraph_->from_vertex(f, n->v) << std::endl;
+      auto dump_locs = [&](const char *what, const loc_t *ls, int nls) {
+        for (int i = 0; i != nls; ++i) {
+          os << "  " << what << " ";
+          print_loc(os, ls[i]);
+          os << " : " << tgraph_->short_name(ls[i].type_id) << " "
+             << storage_names[int(ls[i].storage)] << std::endl;
+        }
+      };
+      dump_locs("DEF", n->defs, n->ndefs);
+      dump_locs("USE", n->uses, n->nuses);
+    }
+    os << "---" << std::endl << std::endl;
+  }
+}
+
+//------------------------------------------------------------------------------
+//
+// Construction helpers
+//
+//------------------------------------------------------------------------------
+
+void locir_t::build_function(int nfunc, func_scratch &fs) {
+  const auto &cn = *contgraph_;
+
+  fs.free_idxs.clear();
+  for (auto it = vassign_->fv_begin(nfunc); it != vassign_->fv_end(nfunc);
+       ++it)
+    if (vassign_->is_index(nfunc, *it))
+      fs.free_idxs.push_back(*it);
+
+  // preorder: childs are pushed reversed
+  fs.nodes.clear();
+  fs.stack.assign(std::make_reverse_iterator(cn.end(nfunc)),
+                  std::make_reverse_iterator(cn.begin(nfunc)));
+  while (!fs.stack.empty()) {
+    cn::vertex_t v = fs.stack.back();
+    fs.stack.pop_back();
+    fs.stack.insert(fs.stack.end(),
+                    std::make_reverse_iterator(cn.end_childs(nfunc, v)),
+                    std::make_reverse_iterator(cn.begin_childs(nfunc, v)));
+
+    auto vp = cn.from_vertex(nfunc, v);
+    node_locs_t nl;
+    nl.v = v;
+    nl.ndefs = vp.defs_end() - vp.defs_begin();
+    nl.nuses = vp.uses_end() - vp.uses_begin();
+    if (nl.ndefs + nl.nuses == 0)
+      continue;
+
+    // uses follow defs in one array
+    fs.locs.clear();
+    for (auto it = vp.defs_begin(); it != vp.uses_end(); ++it)
+      fs.locs.push_back(make_loc(nfunc, *it, fs));
+    nl.defs = arena_.copy(fs.locs.data(), fs.locs.size());
+    nl.uses = nl.defs + nl.ndefs;
+    fs.nodes.push_back(nl);
+  }
+
+  funcs_[nfunc].nodes = arena_.copy(fs.nodes.data(), fs.nodes.size());
+  funcs_[nfunc].nnodes = fs.nodes.size();
+}
+
+loc_t locir_t::make_loc(int nfunc, va::variable_t var, func_scratch &fs) {
+  const auto &tg = *tgraph_;
+  const auto &va = *vassign_;
+
+  loc_t l;
+  l.var = var.id;
+  if (va.is_global(var.id))
+    l.storage = storage_t::GLOBAL;
+  else if (va.is_argument(nfunc, var.id))
+    l.storage = storage_t::ARG;
+
+  auto random_of = [this](auto first, auto last) {
+    return first[config_.rand_positive() % (last - first)];
+  };
+
+  // variable, which type we are inside now
+  int cur = var.id;
+  int tid = var.type_id;
+  fs.steps.clear();
+
+  for (;;) {
+    auto vpt = tg.vertex_from(tid);
+    if (vpt.is_struct()) {
+      int nfields = 0;
+      for (auto it = tg.begin_childs(tid); it != tg.end_childs(tid); ++it)
+        nfields += 1;
+      if (nfields == 0)
+        break;
+      int k = config_.rand_positive() % nfields;
+      fs.steps.push_back({step_kind_t::FIELD, k});
+      tid = (*(tg.begin_childs(tid) + k)).first;
+    } else if (vpt.is_array()) {
+      int idx = -1;
+      if (va.have_accs(nfunc, cur))
+        idx = random_of(va.accs_begin(nfunc, cur), va.accs_end(nfunc, cur));
+      else if (!fs.free_idxs.empty())
+        idx = random_of(fs.free_idxs.begin(), fs.free_idxs.end());
+
+      // permutators are for variable itself, not for inner arrays
+      int perm = -1;
+      bool own = (cur == var.id) && fs.steps.empty();
+      auto pb = va.perms_begin(nfunc, cur), pe = va.perms_end(nfunc, cur);
+      if (own && idx != -1 && pb != pe && cfg::get(config_, LI::PERMUTE))
+        perm = random_of(pb, pe);
+
+      fs.steps.push_back({step_kind_t::INDEX, idx, perm});
+      tid = (*tg.begin_childs(tid)).first;
+    } else if (vpt.is_pointer() && va.have_pointee(nfunc, cur, tid) &&
+               cfg::get(config_, LI::DEREF)) {
+      cur = va.pointee(nfunc, cur, tid);
+      fs.steps.push_back({step_kind_t::DEREF, cur});
+      tid = va.at(cur).type_id;
+    } else {
+      break;
+    }
+  }
+
+  l.type_id = tid;
+  l.npath = fs.steps.size();
+  l.path = arena_.copy(fs.steps.data(), fs.steps.size());
+  return l;
+}
+
+} // namespace li
+
+//------------------------------------------------------------------------------
+//
+// Task system support
+//
+//------------------------------------------------------------------------------
+
+std::shared_ptr<li::locir_t>
+locir_create(int seed, const cfg::config &cf,
+             std::shared_ptr<tg::typegraph_t> sptg,
+             std::shared_ptr<va::varassign_t> spva,
+             std::shared_ptr<cn::controlgraph_t> spcn) {
+  try {
+    cfg::config newcf(seed, cf.quiet(), cf.dumps(), cf.cbegin(), cf.cend());
+    return std::make_shared<li::locir_t>(std::move(newcf), sptg, spva, spcn);
+  } catch (std::runtime_error &e) {
+    std::cerr << "LocIR construction problem: " << e.what() << std::endl;
+    throw;
+  }
+}
+
+void locir_dump(std::shared_ptr<li::locir_t> pl, std::ostream &os) {
+  pl->dump(os);
+}
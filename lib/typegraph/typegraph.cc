@@ -42,7 +42,7 @@ constexpr int npseudos = (sizeof(pseudos) / sizeof(const char *));
 
 static_assert(static_cast<int>(category_t::CATMAX) == npseudos);
 
-// short name for callgraph dumps
+// short name for dumps, interned in typegraph_t::short_name
 std::string vertexprop_t::get_short_name() const {
   std::ostringstream s;
   int catidx = static_cast<int>(cat);
@@ -129,6 +129,9 @@ typegraph_t::typegraph_t(cfg::config &&cf) : config_(std::move(cf)) {
   // choose index-like and perm-like types
   // create if none
   choose_perms_idxs();
+
+  // --- here typegraph is frozen ---
+  intern_names();
 }
 
 // "read myself from file" ctor
@@ -138,6 +141,7 @@ typegraph_t::typegraph_t(const cfg::config &cf, std::string fname)
     std::cout << "Reading typegraph from file: " << fname << std::endl;
   std::ifstream ifstr(fname);
   read(ifstr);
+  intern_names();
 }
 
 vertex_iter_t typegraph_t::begin() const {
@@ -194,26 +198,27 @@ void typegraph_t::read(std::istream &os) {
 //
 //------------------------------------------------------------------------------
 
-vertexprop_t typegraph_t::get_random_type() const {
-  cfg::config_rng cfrng(config_);
+vertexprop_t typegraph_t::get_random_type(const cfg::config &cf) const {
+  cfg::config_rng cfrng(cf);
   vertex_t v = boost::random_vertex(graph_, cfrng);
   return graph_[v];
 }
 
-vertexprop_t typegraph_t::get_random_index_type() const {
+vertexprop_t typegraph_t::get_random_index_type(const cfg::config &cf) const {
   assert(idx_vs_.size() > 0);
-  int idx = config_.rand_positive() % idx_vs_.size();
+  int idx = cf.rand_positive() % idx_vs_.size();
   auto it = idx_vs_.begin();
   std::advance(it, idx);
   vertex_t v = *it;
   return graph_[v];
 }
 
-vertexprop_t typegraph_t::get_random_perm_type(int nelems) const {
+vertexprop_t typegraph_t::get_random_perm_type(const cfg::config &cf,
+                                                int nelems) const {
   assert(nelems > 0);
   assert(perm_vs_.size() >= size_t(nelems));
   assert(perm_vs_[nelems - 1].size() != 0);
-  int idx = config_.rand_positive() % perm_vs_[nelems - 1].size();
+  int idx = cf.rand_positive() % perm_vs_[nelems - 1].size();
   vertex_t v = perm_vs_[nelems - 1][idx];
   return graph_[v];
 }
@@ -544,6 +549,18 @@ void typegraph_t::choose_perms_idxs() {
     }
 }
 
+// type ids are vertex ids, so n-th name is name of n-th vertex
+void typegraph_t::intern_names() {
+  int ntypes = boost::num_vertices(graph_);
+  names_ = utils::string_arena_t{};
+  names_.reserve(ntypes, ntypes * 4);
+  for (int tid = 0; tid < ntypes; ++tid) {
+    int catidx = static_cast<int>(graph_[tid].cat);
+    assert(catidx < npseudos);
+    names_.add_numbered(pseudos[catidx], tid);
+  }
+}
+
 } // namespace tg
 
 //------------------------------------------------------------------------------
@@ -0,0 +1,146 @@
+//------------------------------------------------------------------------------
+//
+// Varassign: global variables layer
+//
+//------------------------------------------------------------------------------
+//
+// This file is licensed after LGPL v3
+// Look at: https://www.gnu.org/licenses/lgpl-3.0.en.html for details
+//
+//------------------------------------------------------------------------------
+
+#include <memory>
+#include <queue>
+
+#include "coelacanth/dbgstream.h"
+#include "globals.h"
+#include "typegraph/typegraph.h"
+
+namespace va {
+
+//------------------------------------------------------------------------------
+//
+// Variable staging
+//
+//------------------------------------------------------------------------------
+
+int staging_t::create_var(int tid) {
+  int vid = base + types.size();
+  types.push_back(tid);
+  return vid;
+}
+
+void staging_t::create_pointee(int vid, int tid) {
+  int pointee_vid = create_var(tg.get_pointee(tid).id);
+  pointees.push_back({vid, {tid, pointee_vid}});
+  vars.push_back(pointee_vid);
+}
+
+void staging_t::process_var(int vid, int tid) {
+  tg::vertexprop_t vpt = tg.vertex_from(tid);
+
+  // create pointees for pointers
+  if (vpt.is_pointer()) {
+    create_pointee(vid, tid);
+  }
+
+  // create permutators for arrays
+  // TODO: we, theoretically, can permute arrays inside structures...
+  //       those "subpermutators" arent now supported
+  if (vpt.is_array()) {
+    int nitems = std::get<tg::array_t>(vpt.type).nitems;
+    int maxperm = cfg::get(cf, VA::MAXPERM);
+    for (int nperms = 0; nperms < maxperm && cfg::get(cf, VA::USEPERM);
+         ++nperms) {
+      int perm_vid = create_var(tg.get_random_perm_type(cf, nitems).id);
+      roles.emplace_back(perm_vid, VR_PERM);
+      perms.emplace_back(vid, perm_vid);
+      vars.push_back(perm_vid);
+    }
+  }
+
+  // create indexes for accessors
+  std::queue<tg::vertexprop_t> chlds;
+  if (vpt.is_complex())
+    chlds.push(vpt);
+
+  while (!chlds.empty()) {
+    auto cpt = chlds.front();
+    chlds.pop();
+
+    if (cpt.is_array()) {
+      int index_vid = create_var(tg.get_random_index_type(cf).id);
+      roles.emplace_back(index_vid, VR_INDEX);
+      accs.emplace_back(vid, index_vid);
+      vars.push_back(index_vid);
+    }
+
+    for (auto cit = tg.begin_childs(cpt.id); cit != tg.end_childs(cpt.id);
+         ++cit) {
+      auto npt = tg.vertex_from((*cit).first);
+      if (npt.is_complex())
+        chlds.push(npt);
+      if (npt.is_pointer())
+        create_pointee(vid, npt.id);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+//
+// Globals layer
+//
+//------------------------------------------------------------------------------
+
+globals_t::globals_t(const cfg::config &cf, const tg::typegraph_t &tgraph) {
+  nprimary_ = cfg::get(cf, VA::NGLOBALS);
+  staging_t gs{cf, tgraph, 0};
+  for (int vidx = 0; vidx != nprimary_; ++vidx)
+    gs.create_var(tgraph.get_random_type(cf).id);
+
+  // helpers of every primary global are contiguous in gs.vars
+  helper_offs_.assign(nprimary_ + 1, 0);
+  for (int gid = 0; gid != nprimary_; ++gid) {
+    gs.process_var(gid, gs.types[gid]);
+    helper_offs_[gid + 1] = gs.vars.size();
+  }
+  helpers_ = std::move(gs.vars);
+
+  int nvars = gs.types.size();
+  vars_.reserve(nvars);
+  names_.reserve(nvars, nvars * 4);
+  for (int vid = 0; vid != nvars; ++vid) {
+    vars_.emplace_back(vid, gs.types[vid]);
+    names_.add_numbered("g", vid);
+  }
+
+  roles_.assign(nvars, 0);
+  for (auto [vid, role] : gs.roles)
+    roles_[vid] |= role;
+  auto slotf = [](int vid) { return vid; };
+  build_csr(nvars, gs.accs, slotf, acc_offs_, accs_);
+  build_csr(nvars, gs.perms, slotf, perm_offs_, perms_);
+  build_csr(nvars, gs.pointees, slotf, pointee_offs_, pointees_);
+}
+
+} // namespace va
+
+//------------------------------------------------------------------------------
+//
+// Task system support
+//
+//------------------------------------------------------------------------------
+
+std::shared_ptr<const va::globals_t>
+globals_create(int seed, const cfg::config &cf,
+               std::shared_ptr<tg::typegraph_t> sptg) {
+  try {
+    cfg::config newcf(seed, cf.quiet(), cf.dumps(), cf.cbegin(), cf.cend());
+    if (!newcf.quiet())
+      dbgs() << "Creating shared globals\n";
+    return std::make_shared<const va::globals_t>(newcf, *sptg);
+  } catch (std::runtime_error &e) {
+    std::cerr << "Globals construction problem: " << e.what() << std::endl;
+    throw;
+  }
+}
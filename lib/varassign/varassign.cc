@@ -9,15 +9,19 @@
 //
 //------------------------------------------------------------------------------
 
-#include <queue>
+#include <tuple>
 
 #include "callgraph/callgraph.h"
 #include "coelacanth/dbgstream.h"
+#include "coelacanth/tasksystem.h"
 #include "typegraph/typegraph.h"
 #include "varassign.h"
 
 namespace va {
 
+// functions are assigned in parallel by chunks of this size
+constexpr int FUNCS_PER_TASK = 32;
+
 //------------------------------------------------------------------------------
 //
 // Varassign public interface
@@ -26,54 +30,80 @@ namespace va {
 
 varassign_t::varassign_t(cfg::config &&cf,
                          std::shared_ptr<tg::typegraph_t> tgraph,
-                         std::shared_ptr<cg::callgraph_t> cgraph)
-    : config_(std::move(cf)), tgraph_(tgraph), cgraph_(cgraph) {
+                         std::shared_ptr<cg::callgraph_t> cgraph,
+                         std::shared_ptr<const globals_t> globals)
+    : config_(std::move(cf)), tgraph_(tgraph), cgraph_(cgraph),
+      globals_(globals) {
   if (!config_.quiet())
     dbgs() << "Creating varassign\n";
 
-  // create global variables
-  int nvars = cfg::get(config_, VA::NGLOBALS);
-  for (int vidx = 0; vidx != nvars; ++vidx) {
-    auto vpt = tgraph_->get_random_type();
-    int vid = create_var(vpt.id);
-    globals_.insert(vid);
-  }
+  // create global variables unless shared layer is given
+  if (!globals_)
+    globals_ = std::make_shared<const globals_t>(config_, *tgraph_);
+  nglobals_ = globals_->size();
 
   // create function variable subsets
-  fvars_.resize(cgraph_->nfuncs());
-  for (auto fit = cgraph_->begin(); fit != cgraph_->end(); ++fit)
-    create_function_vars(*fit);
-}
-
-std::string varassign_t::get_name(int vid, int funcid) const {
-  std::ostringstream os;
-  if (is_global(vid)) {
-    os << "g";
-  } else if ((funcid != -1) && (fvars_[funcid].is_perm(vid))) {
-    os << "p";
-  } else if ((funcid != -1) && (fvars_[funcid].is_index(vid))) {
-    os << "i";
-  } else {
-    os << "v";
+  // every function have own random stream derived from seed, so result
+  // do not depend on scheduling
+  int nfuncs = cgraph_->nfuncs();
+  int seed = config_.rand_positive();
+  int nchunks = (nfuncs + FUNCS_PER_TASK - 1) / FUNCS_PER_TASK;
+  std::vector<std::vector<int>> types(nfuncs);
+  fvars_.resize(nfuncs);
+
+  auto assign_chunk = [&](int nchunk) {
+    cfg::config fcf(config_);
+    int fbeg = nchunk * FUNCS_PER_TASK;
+    int fend = std::min(nfuncs, fbeg + FUNCS_PER_TASK);
+    for (int f = fbeg; f < fend; ++f) {
+      fcf.reseed(cfg::derive_seed(seed, f));
+      types[f] = create_function_vars(f, fcf);
+    }
+  };
+
+  if (nchunks > 1)
+    parallel_for(nchunks, assign_chunk);
+  else if (nchunks == 1)
+    assign_chunk(0);
+
+  // own variables ranges are prefix sums of their numbers
+  for (int f = 0; f != nfuncs; ++f) {
+    auto &fv = fvars_[f];
+    int shift = vars_.size();
+    for (auto tid : types[f])
+      vars_.emplace_back(nglobals_ + vars_.size(), tid);
+    fv.lo_ += shift;
+    fv.hi_ += shift;
+
+    auto relocate = [this, shift](int &vid) {
+      if (!is_global(vid))
+        vid += shift;
+    };
+    for (auto &vid : fv.vars_)
+      relocate(vid);
+    for (auto &vid : fv.accs_)
+      relocate(vid);
+    for (auto &vid : fv.perms_)
+      relocate(vid);
+    for (auto &pt : fv.pointees_)
+      relocate(pt.second);
   }
 
-  os << vid;
-
-  return os.str();
+  // --- here variables are frozen ---
+  intern_names();
 }
 
 void varassign_t::dump(std::ostream &os) const {
   os << "Globals\n";
-  for (auto v : globals_) {
-    auto vpt = tgraph_->vertex_from(vars_[v].type_id);
-    os << vpt.get_short_name() << " " << get_name(v, -1) << std::endl;
+  for (int v = 0; v != nglobals_; ++v) {
+    os << tgraph_->short_name(at(v).type_id) << " " << get_name(v) << "\n";
   }
 
   for (int f = 0, fe = fvars_.size(); f != fe; ++f) {
     os << "Function #" << f << "\n";
     for (auto v : fvars_[f].vars_) {
-      auto vpt = tgraph_->vertex_from(vars_[v].type_id);
-      os << vpt.get_short_name() << " " << get_name(v, f) << std::endl;
+      os << tgraph_->short_name(at(v).type_id) << " " << get_name(v)
+         << "\n";
     }
   }
 }
@@ -84,119 +114,102 @@ void varassign_t::dump(std::ostream &os) const {
 //
 //------------------------------------------------------------------------------
 
-// create single variable and add to storage
-int varassign_t::create_var(int tid) {
-  int vidx = vars_.size();
-  vars_.emplace_back(vidx, tid);
-  return vidx;
-}
-
-void varassign_t::create_pointee(int vid, int tid, func_vars &fv) {
-  int pointee_vid = create_var(tgraph_->get_pointee(tid).id);
-  fv.pointees_[vid][tid] = pointee_vid;
-  fv.vars_.push_back(pointee_vid);
-}
-
-void varassign_t::process_var(int vid, int funcid) {
-  int tid = vars_[vid].type_id;
-  tg::vertexprop_t vpt = tgraph_->vertex_from(tid);
-
-  auto &fv = fvars_[funcid];
-
-  // create pointees for pointers
-  if (vpt.is_pointer()) {
-    create_pointee(vid, tid, fv);
-  }
-
-  // create permutators for arrays
-  // TODO: we, theoretically, can permute arrays inside structures...
-  //       those "subpermutators" arent now supported
-  if (vpt.is_array()) {
-    int nitems = std::get<tg::array_t>(vpt.type).nitems;
-    while (cfg::get(config_, VA::USEPERM)) {
-      int perm_vid = create_var(tgraph_->get_random_perm_type(nitems).id);
-      fv.perms_.insert(perm_vid);
-      fv.permutators_[vid].push_back(perm_vid);
-      fv.vars_.push_back(perm_vid);
-
-      if (cfg::get(config_, VA::MAXPERM) == int(fv.permutators_.size()))
-        break;
-    }
-  }
-
-  // create indexes for accessors
-  std::queue<tg::vertexprop_t> chlds;
-  if (vpt.is_complex())
-    chlds.push(vpt);
-
-  while (!chlds.empty()) {
-    auto cpt = chlds.front();
-    chlds.pop();
-
-    if (cpt.is_array()) {
-      int index_vid = create_var(tgraph_->get_random_index_type().id);
-      fv.indexes_.insert(index_vid);
-      fv.accidxs_[vid].push_back(index_vid);
-      fv.vars_.push_back(index_vid);
-    }
-
-    for (auto cit = tgraph_->begin_childs(cpt.id);
-         cit != tgraph_->end_childs(cpt.id); ++cit) {
-      auto npt = tgraph_->vertex_from((*cit).first);
-      if (npt.is_complex())
-        chlds.push(npt);
-      if (npt.is_pointer())
-        create_pointee(vid, npt.id, fv);
-    }
-  }
+int varassign_t::find_pointee(int nfunc, int vid, int tid) const {
+  if (is_global(vid))
+    return globals_->find_pointee(vid, tid);
+  auto &fv = fvars_[nfunc];
+  int s = slot(nfunc, vid);
+  if (s == -1)
+    return -1;
+  for (int i = fv.pointee_offs_[s + 1]; i != fv.pointee_offs_[s]; --i)
+    if (fv.pointees_[i - 1].first == tid)
+      return fv.pointees_[i - 1].second;
+  return -1;
 }
 
-void varassign_t::create_function_vars(int funcid) {
+// builds fvars_[funcid] and returns types of function own variables.
+// Function is built independently of others, so its own variables get
+// staging ids nglobals + n, where n is index in returned types, and are
+// shifted to real range when all functions are done. Touches nothing but
+// fvars_[funcid], so may run in parallel for different functions
+std::vector<int> varassign_t::create_function_vars(int funcid,
+                                                   const cfg::config &cf) {
   assert(funcid < cgraph_->nfuncs());
-  cfg::config_rng cfrng(config_);
+  staging_t fs{cf, *tgraph_, nglobals_};
   auto &fv = fvars_[funcid];
+  fv.lo_ = nglobals_;
 
   // add free indexes
-  int nidx = cfg::get(config_, VA::NIDX);
+  int nidx = cfg::get(cf, VA::NIDX);
   for (int vidx = 0; vidx != nidx; ++vidx) {
-    int iid = create_var(tgraph_->get_random_index_type().id);
-    fv.register_index(iid);
+    int iid = fs.create_var(tgraph_->get_random_index_type(cf).id);
+    fs.roles.emplace_back(iid, VR_INDEX);
+    fs.vars.push_back(iid);
   }
 
-  // choose from all globals, those, that conform to metastructure
-  for (auto gid : globals_) {
-    if (!cgraph_->accept_type(funcid, gid))
+  // choose from primary globals, those, that conform to metastructure
+  // their helpers are already in globals layer
+  for (int gid = 0, ge = globals_->nprimary(); gid != ge; ++gid) {
+    if (!cgraph_->accept_type(funcid, at(gid).type_id))
       continue;
-    fv.vars_.push_back(gid);
-    process_var(gid, funcid);
+    fs.vars.push_back(gid);
+    fs.vars.insert(fs.vars.end(), globals_->helpers_begin(gid),
+                   globals_->helpers_end(gid));
   }
 
-  // add local variables
-  int vidx = 0;
-  int nvars = cfg::get(config_, MS::NVARS);
-  int nvatts = cfg::get(config_, VA::NVATTS);
-  while (vidx < nvars) {
-    auto vpt = tgraph_->get_random_type();
-    if (cgraph_->accept_type(funcid, vpt.id)) {
-      int vid = create_var(vpt.id);
-      fv.vars_.push_back(vid);
-      process_var(vid, funcid);
-      vidx += 1;
-    }
-    if (nvatts == 0)
-      break;
-    nvatts -= 1;
+  // add local variables, types are uniform over accepted by function
+  int nvars = cfg::get(cf, MS::NVARS);
+  int naccepted = cgraph_->naccepted(funcid);
+  for (int vidx = 0; naccepted > 0 && vidx < nvars; ++vidx) {
+    int tid = cgraph_->accepted_type(funcid, cf.rand_positive() % naccepted);
+    int vid = fs.create_var(tid);
+    fs.vars.push_back(vid);
+    fs.process_var(vid, tid);
   }
 
   // add argument variables
   auto vpt = cgraph_->vertex_from(funcid);
 
   for (auto tid : vpt.argtypes) {
-    int vid = create_var(tid);
-    fv.args_.insert(vid);
-    fv.vars_.push_back(vid);
-    process_var(vid, funcid);
+    int vid = fs.create_var(tid);
+    fs.roles.emplace_back(vid, VR_ARG);
+    fs.vars.push_back(vid);
+    fs.process_var(vid, tid);
   }
+
+  // freeze into dense tables
+  fv.hi_ = nglobals_ + fs.types.size();
+  int nslots = fv.hi_ - fv.lo_;
+  auto slotf = [this, funcid](int vid) { return slot(funcid, vid); };
+
+  fv.vars_ = std::move(fs.vars);
+  fv.roles_.assign(nslots, 0);
+  for (auto [vid, role] : fs.roles)
+    fv.roles_[slotf(vid)] |= role;
+  build_csr(nslots, fs.accs, slotf, fv.acc_offs_, fv.accs_);
+  build_csr(nslots, fs.perms, slotf, fv.perm_offs_, fv.perms_);
+  build_csr(nslots, fs.pointees, slotf, fv.pointee_offs_, fv.pointees_);
+  return std::move(fs.types);
+}
+
+// every local variable is owned by exactly one function, so name prefix is
+// decided by its role there: p and i for permutators and indexes, v for all
+// others. Globals are named in their own layer
+void varassign_t::intern_names() {
+  int nvars = vars_.size();
+  names_.reserve(nvars, nvars * 5);
+
+  for (int f = 0, fe = fvars_.size(); f != fe; ++f)
+    for (int vid = fvars_[f].lo_; vid != fvars_[f].hi_; ++vid) {
+      const char *prefix = "v";
+      if (is_perm(f, vid))
+        prefix = "p";
+      else if (is_index(f, vid))
+        prefix = "i";
+      names_.add_numbered(prefix, vid);
+    }
+
+  assert(names_.size() == nvars);
 }
 
 } // namespace va
@@ -210,10 +223,12 @@ void varassign_t::create_function_vars(int funcid) {
 std::shared_ptr<va::varassign_t>
 varassign_create(int seed, const cfg::config &cf,
                  std::shared_ptr<tg::typegraph_t> sptg,
-                 std::shared_ptr<cg::callgraph_t> spcg) {
+                 std::shared_ptr<cg::callgraph_t> spcg,
+                 std::shared_ptr<const va::globals_t> spgl) {
   try {
     cfg::config newcf(seed, cf.quiet(), cf.dumps(), cf.cbegin(), cf.cend());
-    return std::make_shared<va::varassign_t>(std::move(newcf), sptg, spcg);
+    return std::make_shared<va::varassign_t>(std::move(newcf), sptg, spcg,
+                                             spgl);
   } catch (std::runtime_error &e) {
     std::cerr << "Varassign construction problem: " << e.what() << std::endl;
     throw;
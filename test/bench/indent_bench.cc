@@ -0,0 +1,102 @@
+//------------------------------------------------------------------------------
+//
+// Benchmarks: indentation stream throughput for different write sizes.
+//
+// Results are only reported in MB/s of input (see --log_level=message), but
+// outputs are checked to agree. Writing char by char is the path every
+// character took before filter got whole blocks, tokens are about the size
+// of what C printer writes at once.
+//
+//------------------------------------------------------------------------------
+//
+// This file is licensed after LGPL v3
+// Look at: https://www.gnu.org/licenses/lgpl-3.0.en.html for details
+//
+//------------------------------------------------------------------------------
+
+#include "utils/indent_ostream.h"
+
+#include <boost/test/unit_test.hpp>
+#include <boost/timer/timer.hpp>
+
+#include <algorithm>
+#include <random>
+#include <sstream>
+#include <string>
+
+namespace {
+
+constexpr int NBYTES = 1 << 19;
+constexpr int NREPS = 4;
+constexpr int TOKEN = 4;
+
+// Program-like text: lines of random length, some of them empty.
+std::string bench_text() {
+  std::mt19937 gen{42};
+  std::string s;
+  s.reserve(NBYTES + 128);
+  while (s.size() < NBYTES) {
+    int len = gen() % 8 == 0 ? 0 : 8 + gen() % 64;
+    for (int i = 0; i < len; ++i)
+      s.push_back('a' + gen() % 26);
+    s.push_back('\n');
+  }
+  return s;
+}
+
+// Writes text NREPS times with nested indentation, returns output of last.
+template <typename F>
+std::string run(const char *what, const std::string &text, F write) {
+  std::string out;
+  boost::timer::cpu_timer t;
+  for (int r = 0; r < NREPS; ++r) {
+    std::ostringstream oss;
+    utils::indent_ostream_t ios{oss, 2};
+    ios << utils::increase_indent << utils::increase_indent << "\n";
+    write(ios, text);
+    ios.flush();
+    out = oss.str();
+  }
+  t.stop();
+
+  double secs = double(t.elapsed().wall) / 1e9;
+  double mbs = double(text.size()) * NREPS / (1 << 20) / secs;
+  BOOST_TEST_MESSAGE(what << ": " << mbs << " MB/s");
+  return out;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(utils_tests)
+
+BOOST_AUTO_TEST_SUITE(indent_bench)
+
+BOOST_AUTO_TEST_CASE(throughput) {
+  std::string text = bench_text();
+
+  auto bychar = run("char by char", text,
+                    [](std::ostream &os, const std::string &s) {
+                      for (char c : s)
+                        os.put(c);
+                    });
+
+  auto bytoken = run("tokens", text,
+                     [](std::ostream &os, const std::string &s) {
+                       for (std::size_t i = 0; i < s.size(); i += TOKEN)
+                         os.write(s.data() + i,
+                                  std::min<std::size_t>(TOKEN, s.size() - i));
+                     });
+
+  auto whole = run("whole buffer", text,
+                   [](std::ostream &os, const std::string &s) {
+                     os.write(s.data(), s.size());
+                   });
+
+  BOOST_TEST(bychar.size() > text.size());
+  BOOST_TEST(bychar == bytoken);
+  BOOST_TEST(bychar == whole);
+}
+
+BOOST_AUTO_TEST_SUITE_END() // indent_bench
+
+BOOST_AUTO_TEST_SUITE_END() // utils_tests
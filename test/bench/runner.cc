@@ -0,0 +1,14 @@
+//------------------------------------------------------------------------------
+//
+// This file defines main function of benchmarks. They use boost test
+// framework only to be run and filtered the same way unit tests are.
+//
+//------------------------------------------------------------------------------
+//
+// This file is licensed after LGPL v3
+// Look at: https://www.gnu.org/licenses/lgpl-3.0.en.html for details
+//
+//------------------------------------------------------------------------------
+
+#define BOOST_TEST_MODULE coelacanth benchmarks
+#include <boost/test/unit_test.hpp>
@@ -0,0 +1,124 @@
+//------------------------------------------------------------------------------
+//
+// Benchmarks: pointer-chasing iteration vs flattened snapshots of semitree.
+//
+// Results are only reported (see --log_level=message), but traversals are
+// checked to agree. Nodes are created in pool in random order of insertion,
+// so neighbours in tree are not neighbours in memory, like in real trees
+// grown by splitting.
+//
+//------------------------------------------------------------------------------
+//
+// This file is licensed after LGPL v3
+// Look at: https://www.gnu.org/licenses/lgpl-3.0.en.html for details
+//
+//------------------------------------------------------------------------------
+
+#include "tree.h"
+
+#include <boost/test/unit_test.hpp>
+#include <boost/timer/timer.hpp>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr int NNODES = 1 << 16;
+constexpr int NREPS = 16;
+
+// Random tree: every new branch goes under random existing one.
+struct bench_tree {
+  tree tr;
+  semitree::node_pool_t<branch> pool;
+
+  bench_tree() {
+    std::mt19937 gen{42};
+    std::vector<branch *> nodes;
+    for (int i = 0; i < NNODES; ++i) {
+      branch &b = pool.create(i);
+      if (nodes.empty() || gen() % 8 == 0) {
+        tr.insert(tr.end(), b);
+      } else {
+        branch &p = *nodes[gen() % nodes.size()];
+        p.insert(p.begin(), b);
+      }
+      nodes.push_back(&b);
+    }
+  }
+};
+
+void report(const char *what, const boost::timer::cpu_timer &t,
+            int npasses = NREPS) {
+  double ms = double(t.elapsed().wall) / 1e6 / npasses;
+  BOOST_TEST_MESSAGE(what << ": " << ms << " ms per pass");
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(semitree)
+
+BOOST_AUTO_TEST_SUITE(bench)
+
+BOOST_AUTO_TEST_CASE(preorder_sum) {
+  bench_tree bt;
+  const tree &ctr = bt.tr;
+  long long ptrsum = 0, flatsum = 0;
+
+  boost::timer::cpu_timer tptr;
+  for (int r = 0; r < NREPS; ++r)
+    for (auto it = ctr.inorder_begin(); it != ctr.inorder_end(); ++it)
+      if (!it->visited)
+        ptrsum += it->ref.get_data();
+  tptr.stop();
+
+  boost::timer::cpu_timer tflat;
+  auto ft = ctr.flatten();
+  tflat.stop();
+  boost::timer::cpu_timer tscan;
+  for (int r = 0; r < NREPS; ++r)
+    for (auto &e : ft)
+      flatsum += e.node->get_data();
+  tscan.stop();
+
+  BOOST_TEST(ptrsum == flatsum);
+  BOOST_TEST(ft.size() == NNODES);
+  report("inorder iterator", tptr);
+  report("flatten", tflat, 1);
+  report("flat scan", tscan);
+}
+
+// Depth is free in snapshot, iterator has to track it.
+BOOST_AUTO_TEST_CASE(depth_sum) {
+  bench_tree bt;
+  const tree &ctr = bt.tr;
+  long long ptrsum = 0, flatsum = 0;
+
+  boost::timer::cpu_timer tptr;
+  for (int r = 0; r < NREPS; ++r) {
+    int depth = 0;
+    for (auto it = ctr.inorder_begin(); it != ctr.inorder_end(); ++it) {
+      if (it->visited) {
+        depth -= 1;
+        continue;
+      }
+      ptrsum += depth;
+      depth += 1;
+    }
+  }
+  tptr.stop();
+
+  auto ft = ctr.flatten();
+  boost::timer::cpu_timer tscan;
+  for (int r = 0; r < NREPS; ++r)
+    for (auto &e : ft)
+      flatsum += e.depth;
+  tscan.stop();
+
+  BOOST_TEST(ptrsum == flatsum);
+  report("inorder iterator with depth", tptr);
+  report("flat scan with depth", tscan);
+}
+
+BOOST_AUTO_TEST_SUITE_END() // bench
+
+BOOST_AUTO_TEST_SUITE_END() // semitree
@@ -0,0 +1,59 @@
+#-------------------------------------------------------------------------------
+#
+# Coelacanth build system -- generated programs run test
+#
+#-------------------------------------------------------------------------------
+#
+# Generates programs for given seeds with one randomization on every level,
+# compiles every program with given C compiler and runs it. Any failure to
+# compile, nonzero exit code or timeout fails the test.
+#
+# Expects COELACANTH, CC, CFLAGS (list, may be empty), SEEDS (space
+# separated), OPTS (extra coelacanth options, space separated, may be empty)
+# and WORKDIR.
+#
+#-------------------------------------------------------------------------------
+
+separate_arguments(SEEDS UNIX_COMMAND "${SEEDS}")
+separate_arguments(OPTS UNIX_COMMAND "${OPTS}")
+
+file(REMOVE_RECURSE ${WORKDIR})
+
+foreach(SEED ${SEEDS})
+  set(DIR ${WORKDIR}/${SEED})
+  file(MAKE_DIRECTORY ${DIR})
+  execute_process(
+    COMMAND ${COELACANTH} --seed ${SEED} --quiet --pg-var 1 --pg-splits 1
+            --pg-locs 1 --pg-arith 1 ${OPTS}
+    WORKING_DIRECTORY ${DIR}
+    RESULT_VARIABLE RES
+    TIMEOUT 300)
+  if (NOT RES EQUAL 0)
+    message(FATAL_ERROR "coelacanth failed for seed ${SEED}: ${RES}")
+  endif()
+
+  file(GLOB PROGRAMS ${DIR}/program.*.c)
+  if (NOT PROGRAMS)
+    message(FATAL_ERROR "No programs generated for seed ${SEED}")
+  endif()
+
+  foreach(PROG ${PROGRAMS})
+    execute_process(
+      COMMAND ${CC} -std=c11 -w ${CFLAGS} ${PROG} -o ${PROG}.out
+      RESULT_VARIABLE RES
+      ERROR_VARIABLE ERR)
+    if (NOT RES EQUAL 0)
+      message(FATAL_ERROR "${PROG} does not compile:\n${ERR}")
+    endif()
+
+    execute_process(
+      COMMAND ${PROG}.out
+      RESULT_VARIABLE RES
+      ERROR_VARIABLE ERR
+      TIMEOUT 60)
+    if (NOT RES EQUAL 0)
+      message(FATAL_ERROR "${PROG} failed: ${RES}\n${ERR}")
+    endif()
+    message(STATUS "${PROG}: ok")
+  endforeach()
+endforeach()
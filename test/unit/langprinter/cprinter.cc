@@ -0,0 +1,48 @@
+//------------------------------------------------------------------------------
+//
+// Shape of expressions printed by C printer.
+//
+//------------------------------------------------------------------------------
+//
+// This file is licensed after LGPL v3
+// Look at: https://www.gnu.org/licenses/lgpl-3.0.en.html for details
+//
+//------------------------------------------------------------------------------
+
+#include "langprinter/cprinter.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <sstream>
+#include <string>
+
+BOOST_AUTO_TEST_SUITE(langprinter_tests)
+
+BOOST_AUTO_TEST_SUITE(cprinter)
+
+// Both operands are converted to unsigned long long before operation and
+// only result is casted back, so signed overflow can not happen.
+BOOST_AUTO_TEST_CASE(wrapping_binary) {
+  std::ostringstream oss;
+  lp::print_wrapping(
+      oss, "T5", "*", [&oss] { oss << "v1"; }, [&oss] { oss << "g2.f0"; });
+  BOOST_TEST(oss.str() ==
+             "((T5)((unsigned long long)(v1) * (unsigned long long)(g2.f0)))");
+}
+
+// Nested operations stay wrapped at every level.
+BOOST_AUTO_TEST_CASE(wrapping_nested) {
+  std::ostringstream oss;
+  auto inner = [&oss] {
+    lp::print_wrapping(
+        oss, "T1", "-", [&oss] { oss << "0"; }, [&oss] { oss << "v3"; });
+  };
+  lp::print_wrapping(oss, "T1", "+", inner, [&oss] { oss << "7"; });
+  BOOST_TEST(oss.str() == "((T1)((unsigned long long)(((T1)((unsigned long "
+                          "long)(0) - (unsigned long long)(v3)))) + (unsigned "
+                          "long long)(7)))");
+}
+
+BOOST_AUTO_TEST_SUITE_END() // cprinter
+
+BOOST_AUTO_TEST_SUITE_END() // langprinter_tests
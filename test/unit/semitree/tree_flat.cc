@@ -0,0 +1,180 @@
+//------------------------------------------------------------------------------
+//
+// Node pool and flattened snapshot tests for intrusive inorder semitree.
+//
+//------------------------------------------------------------------------------
+//
+// This file is licensed after LGPL v3
+// Look at: https://www.gnu.org/licenses/lgpl-3.0.en.html for details
+//
+//------------------------------------------------------------------------------
+
+#include "tree.h"
+
+#include <boost/test/unit_test.hpp>
+#include <random>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(semitree)
+
+BOOST_AUTO_TEST_SUITE(flat)
+
+// Pool nodes are numbered in creation order and do not move.
+BOOST_AUTO_TEST_CASE(pool_create) {
+  semitree::node_pool_t<branch, 2> pool;
+  BOOST_TEST(pool.empty());
+
+  std::vector<branch *> ptrs;
+  for (int i = 0; i < 10; ++i)
+    ptrs.push_back(&pool.create(i));
+
+  BOOST_TEST(pool.size() == 10);
+  for (int i = 0; i < 10; ++i) {
+    BOOST_TEST(&pool[i] == ptrs[i]);
+    BOOST_TEST(pool[i].get_data() == i);
+  }
+
+  // Links made before pool growth survive it.
+  pool[0].insert(pool[0].end(), pool[1]);
+  for (int i = 0; i < 10; ++i)
+    pool.create(100 + i);
+  BOOST_TEST(&pool[0].get_firstchild() == ptrs[1]);
+
+  pool.clear();
+  BOOST_TEST(pool.empty());
+}
+
+//    b1{1}     l2{4}
+// l1{2} b2{3}
+//       l3{5}
+struct sample_tree {
+  tree tr;
+  branch b1{1};
+  leaf l1{2};
+  branch b2{3};
+  leaf l2{4};
+  leaf l3{5};
+
+  sample_tree() {
+    tr.insert(tr.end(), b1);
+    tr.insert(tr.end(), l2);
+    b1.insert(b1.end(), l1);
+    b1.insert(b1.end(), b2);
+    b2.insert(b2.end(), l3);
+  }
+};
+
+BOOST_AUTO_TEST_CASE(preorder) {
+  sample_tree s;
+  auto ft = s.tr.flatten();
+  BOOST_TEST_REQUIRE(ft.size() == 5);
+
+  std::vector<int> data, depth, end;
+  for (auto &e : ft) {
+    data.push_back(e.node->get_data());
+    depth.push_back(e.depth);
+    end.push_back(e.end);
+    BOOST_TEST(!e.visited);
+  }
+
+  std::vector<int> edata{1, 2, 3, 5, 4};
+  std::vector<int> edepth{0, 1, 1, 2, 0};
+  std::vector<int> eend{4, 2, 4, 4, 5};
+  BOOST_TEST(data == edata, boost::test_tools::per_element());
+  BOOST_TEST(depth == edepth, boost::test_tools::per_element());
+  BOOST_TEST(end == eend, boost::test_tools::per_element());
+}
+
+// Euler tour is the same sequence inorder iterator gives.
+BOOST_AUTO_TEST_CASE(euler) {
+  sample_tree s;
+  auto ft = s.tr.flatten(semitree::flatten_order_t::EULER);
+  BOOST_TEST_REQUIRE(ft.size() == 7);
+
+  auto it = s.tr.inorder_begin();
+  for (auto &e : ft) {
+    BOOST_TEST(&it->ref == e.node);
+    BOOST_TEST(it->visited == e.visited);
+    ++it;
+  }
+  BOOST_TEST(it == s.tr.inorder_end());
+
+  // b1 subtree spans up to and including its closing entry.
+  BOOST_TEST(ft[0].end == 6);
+  BOOST_TEST(ft[5].node == ft[0].node);
+  BOOST_TEST(ft[5].visited);
+}
+
+// Flattening of single branch gives its descendants only.
+BOOST_AUTO_TEST_CASE(subtree) {
+  sample_tree s;
+  auto ft = semitree::flatten(static_cast<const branch &>(s.b2));
+  BOOST_TEST_REQUIRE(ft.size() == 1);
+  BOOST_TEST(ft[0].node == &s.l3);
+  BOOST_TEST(ft[0].depth == 0);
+
+  branch empty;
+  BOOST_TEST(semitree::flatten(static_cast<const branch &>(empty)).empty());
+}
+
+// Tree rebuilt from preorder snapshot by depths flattens to the same snapshot
+// and agrees with inorder iterator. Nodes are inserted in random order, so
+// pool order is not tree order.
+BOOST_AUTO_TEST_CASE(roundtrip) {
+  std::mt19937 gen{42};
+  tree tr;
+  semitree::node_pool_t<branch> pool;
+  for (int i = 0; i < 1000; ++i) {
+    branch &b = pool.create(i);
+    if (i == 0 || gen() % 8 == 0) {
+      tr.insert(tr.end(), b);
+    } else {
+      branch &p = pool[gen() % i];
+      p.insert(p.begin(), b);
+    }
+  }
+
+  const tree &ctr = tr;
+  auto ft = ctr.flatten();
+  BOOST_TEST_REQUIRE(ft.size() == pool.size());
+
+  int depth = 0;
+  auto fit = ft.begin();
+  for (auto it = ctr.inorder_begin(); it != ctr.inorder_end(); ++it) {
+    if (it->visited) {
+      depth -= 1;
+      continue;
+    }
+    BOOST_TEST_REQUIRE((fit != ft.end()));
+    BOOST_TEST(&it->ref == fit->node);
+    BOOST_TEST(depth == fit->depth);
+    depth += 1;
+    ++fit;
+  }
+  BOOST_TEST((fit == ft.end()));
+
+  tree copy;
+  semitree::node_pool_t<branch> cpool;
+  std::vector<branch *> parents;
+  for (auto &e : ft) {
+    branch &b = cpool.create(e.node->get_data());
+    parents.resize(e.depth);
+    if (parents.empty())
+      copy.insert(copy.end(), b);
+    else
+      parents.back()->insert(parents.back()->end(), b);
+    parents.push_back(&b);
+  }
+
+  auto cft = static_cast<const tree &>(copy).flatten();
+  BOOST_TEST_REQUIRE(cft.size() == ft.size());
+  for (std::size_t i = 0; i < ft.size(); ++i) {
+    BOOST_TEST(cft[i].node->get_data() == ft[i].node->get_data());
+    BOOST_TEST(cft[i].depth == ft[i].depth);
+    BOOST_TEST(cft[i].end == ft[i].end);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END() // flat
+
+BOOST_AUTO_TEST_SUITE_END() // semitree
@@ -163,6 +163,41 @@ BOOST_AUTO_TEST_CASE(inorder) {
   BOOST_TEST(std::accumulate(ns.begin(), ns.end(), 0) == 41);
 }
 
+// Constant inorder iterators walk the same path as non-constant ones.
+BOOST_AUTO_TEST_CASE(const_inorder) {
+  tree tr;
+  branch b1{1};
+  leaf l1{2};
+  branch b2{3};
+  leaf l2{4};
+
+  //    b1{1}     l2{4}
+  // l1{2} b2{3}
+  tr.insert(tr.end(), b1);
+  tr.insert(tr.end(), l2);
+  b1.insert(b1.end(), l1);
+  b1.insert(b1.end(), b2);
+
+  // Leafs may come visited from operator--, only branch state matters.
+  auto visited_sign = [](const auto &desc) {
+    return (desc.visited && desc.ref.is_branch()) ? -1 : 1;
+  };
+  const tree &ctr{tr};
+  std::vector<int> ns;
+  for (auto it = ctr.inorder_begin(); it != ctr.inorder_end(); ++it)
+    ns.push_back(visited_sign(*it) * it->ref.get_data());
+  std::vector<int> expected{1, 2, 3, -3, -1, 4};
+  BOOST_TEST(ns == expected, boost::test_tools::per_element());
+
+  ns.clear();
+  for (auto it = ctr.inorder_end(); it != ctr.inorder_begin();) {
+    --it;
+    ns.push_back(visited_sign(*it) * it->ref.get_data());
+  }
+  std::reverse(expected.begin(), expected.end());
+  BOOST_TEST(ns == expected, boost::test_tools::per_element());
+}
+
 BOOST_AUTO_TEST_SUITE_END() // iteration
 
 BOOST_AUTO_TEST_SUITE_END() // semitree
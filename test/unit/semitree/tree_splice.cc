@@ -0,0 +1,244 @@
+//------------------------------------------------------------------------------
+//
+// Detach, splice and move tests for intrusive inorder semitree.
+//
+//------------------------------------------------------------------------------
+//
+// This file is licensed after LGPL v3
+// Look at: https://www.gnu.org/licenses/lgpl-3.0.en.html for details
+//
+//------------------------------------------------------------------------------
+
+#include "tree.h"
+
+#include <algorithm>
+#include <boost/test/unit_test.hpp>
+#include <iterator>
+#include <vector>
+
+namespace {
+
+// Children data of branch or tree. Also checks that backward links and
+// parent links agree with forward ones.
+template <typename B> std::vector<int> children(const B &b) {
+  std::vector<int> fwd, bwd;
+  const void *parent = nullptr;
+  for (auto it = b.begin(); it != b.end(); ++it) {
+    fwd.push_back(it->get_data());
+    BOOST_TEST(&it->get_next().get_prev() == &*it);
+    BOOST_TEST(it->has_parent());
+    if (!parent)
+      parent = &it->get_parent();
+    BOOST_TEST(&it->get_parent() == parent);
+  }
+  for (auto it = b.end(); it != b.begin();)
+    bwd.push_back((--it)->get_data());
+  std::reverse(bwd.begin(), bwd.end());
+  BOOST_TEST(fwd == bwd, boost::test_tools::per_element());
+  BOOST_TEST(b.empty() == fwd.empty());
+  return fwd;
+}
+
+// Inorder sequence, visited branches negated.
+std::vector<int> inorder(const tree &tr) {
+  std::vector<int> res;
+  for (auto it = tr.inorder_begin(); it != tr.inorder_end(); ++it) {
+    int d = it->ref.get_data();
+    res.push_back((it->visited && it->ref.is_branch()) ? -d : d);
+  }
+  return res;
+}
+
+using ints = std::vector<int>;
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(semitree)
+
+BOOST_AUTO_TEST_SUITE(splice)
+
+BOOST_AUTO_TEST_CASE(detach_leafs) {
+  branch b;
+  leaf l1{1}, l2{2}, l3{3};
+  b.insert(b.end(), l1);
+  b.insert(b.end(), l2);
+  b.insert(b.end(), l3);
+
+  // Middle one.
+  auto next = b.detach(l2.get_sibling_iterator());
+  BOOST_TEST(&*next == &l3);
+  BOOST_TEST(!l2.has_parent());
+  BOOST_TEST(children(b) == (ints{1, 3}), boost::test_tools::per_element());
+
+  // Last one, next is end.
+  next = b.detach(l3.get_sibling_iterator());
+  BOOST_TEST(next == b.end());
+  BOOST_TEST(children(b) == (ints{1}), boost::test_tools::per_element());
+
+  // Only one, branch becomes empty.
+  next = b.detach(b.begin());
+  BOOST_TEST(next == b.end());
+  BOOST_TEST(b.empty());
+  BOOST_TEST(b.begin() == b.end());
+  BOOST_TEST(&b.get_firstchild() == &*b.end());
+  BOOST_TEST(&b.get_lastchild() == &*b.end());
+
+  // Detached nodes may be inserted again.
+  b.insert(b.end(), l3);
+  b.insert(b.end(), l2);
+  b.insert(b.end(), l1);
+  BOOST_TEST(children(b) == (ints{3, 2, 1}), boost::test_tools::per_element());
+}
+
+// Detached branch keeps its subtree.
+BOOST_AUTO_TEST_CASE(detach_subtree) {
+  tree tr;
+  branch b1{1}, b2{2};
+  leaf l1{3}, l2{4}, l3{5};
+  tr.insert(tr.end(), b1);
+  tr.insert(tr.end(), l3);
+  b1.insert(b1.end(), l1);
+  b1.insert(b1.end(), b2);
+  b2.insert(b2.end(), l2);
+
+  auto next = tr.detach(tr.begin());
+  BOOST_TEST(&*next == &l3);
+  BOOST_TEST(!b1.has_parent());
+  BOOST_TEST(children(tr) == (ints{5}), boost::test_tools::per_element());
+  BOOST_TEST(children(b1) == (ints{3, 2}), boost::test_tools::per_element());
+  BOOST_TEST(&l2.get_parent() == &b2);
+  BOOST_TEST(inorder(tr) == (ints{5}), boost::test_tools::per_element());
+
+  tr.insert(tr.end(), b1);
+  BOOST_TEST(inorder(tr) == (ints{5, 1, 3, 2, 4, -2, -1}),
+             boost::test_tools::per_element());
+}
+
+// Reordering inside one branch.
+BOOST_AUTO_TEST_CASE(splice_same_parent) {
+  branch b;
+  leaf l1{1}, l2{2}, l3{3}, l4{4}, l5{5};
+  for (leaf *l : {&l1, &l2, &l3, &l4, &l5})
+    b.insert(b.end(), *l);
+
+  // [2, 4) to the end.
+  auto first = l2.get_sibling_iterator();
+  auto last = l4.get_sibling_iterator();
+  auto pos = b.splice(b.end(), first, last);
+  BOOST_TEST(pos == b.end());
+  BOOST_TEST(children(b) == (ints{1, 4, 5, 2, 3}),
+             boost::test_tools::per_element());
+
+  // [5, end) to the front.
+  b.splice(b.begin(), l5.get_sibling_iterator(), b.end());
+  BOOST_TEST(children(b) == (ints{5, 2, 3, 1, 4}),
+             boost::test_tools::per_element());
+
+  // Empty range and splice right before range end are no-ops.
+  b.splice(b.begin(), b.end(), b.end());
+  b.splice(l4.get_sibling_iterator(), l1.get_sibling_iterator(),
+           l4.get_sibling_iterator());
+  BOOST_TEST(children(b) == (ints{5, 2, 3, 1, 4}),
+             boost::test_tools::per_element());
+
+  // Whole list at once.
+  b.splice(b.end(), b.begin(), b.end());
+  BOOST_TEST(children(b) == (ints{5, 2, 3, 1, 4}),
+             boost::test_tools::per_element());
+}
+
+// Range moves with subtrees and gets new parent.
+BOOST_AUTO_TEST_CASE(splice_other_parent) {
+  tree tr;
+  branch b1{1}, b2{2}, b3{3};
+  leaf l1{4}, l2{5}, l3{6};
+  tr.insert(tr.end(), b1);
+  tr.insert(tr.end(), b2);
+  b1.insert(b1.end(), l1);
+  b1.insert(b1.end(), b3);
+  b1.insert(b1.end(), l2);
+  b3.insert(b3.end(), l3);
+  //      b1{1}         b2{2}
+  // l1{4} b3{3} l2{5}
+  //       l3{6}
+
+  b2.splice(b2.end(), l1.get_sibling_iterator(), l2.get_sibling_iterator());
+  BOOST_TEST(children(b1) == (ints{5}), boost::test_tools::per_element());
+  BOOST_TEST(children(b2) == (ints{4, 3}), boost::test_tools::per_element());
+  BOOST_TEST(&b3.get_parent() == &b2);
+  BOOST_TEST(&l3.get_parent() == &b3);
+  BOOST_TEST(inorder(tr) == (ints{1, 5, -1, 2, 4, 3, 6, -3, -2}),
+             boost::test_tools::per_element());
+
+  // All children of b2 before b1 top-level.
+  tr.splice(b1.get_sibling_iterator(), b2.begin(), b2.end());
+  BOOST_TEST(b2.empty());
+  BOOST_TEST(children(tr) == (ints{4, 3, 1, 2}),
+             boost::test_tools::per_element());
+  BOOST_TEST(inorder(tr) == (ints{4, 3, 6, -3, 1, 5, -1, 2, -2}),
+             boost::test_tools::per_element());
+
+  // And back from top-level to empty branch.
+  b2.splice(b2.end(), tr.begin(), b1.get_sibling_iterator());
+  BOOST_TEST(children(tr) == (ints{1, 2}), boost::test_tools::per_element());
+  BOOST_TEST(children(b2) == (ints{4, 3}), boost::test_tools::per_element());
+}
+
+BOOST_AUTO_TEST_CASE(move_nodes) {
+  tree tr;
+  branch b1{1}, b2{2};
+  leaf l1{3}, l2{4}, l3{5};
+  tr.insert(tr.end(), b1);
+  tr.insert(tr.end(), b2);
+  b1.insert(b1.end(), l1);
+  b1.insert(b1.end(), l2);
+
+  // Orphan.
+  auto pos = b2.move(b2.end(), l3);
+  BOOST_TEST(pos == b2.end());
+  BOOST_TEST(children(b2) == (ints{5}), boost::test_tools::per_element());
+
+  // Between branches.
+  b2.move(b2.begin(), l2);
+  BOOST_TEST(children(b1) == (ints{3}), boost::test_tools::per_element());
+  BOOST_TEST(children(b2) == (ints{4, 5}), boost::test_tools::per_element());
+
+  // Inside one branch, including moving before itself.
+  b2.move(b2.end(), l2);
+  BOOST_TEST(children(b2) == (ints{5, 4}), boost::test_tools::per_element());
+  b2.move(l2.get_sibling_iterator(), l2);
+  BOOST_TEST(children(b2) == (ints{5, 4}), boost::test_tools::per_element());
+
+  // Subtree under other subtree.
+  b1.move(b1.end(), b2);
+  BOOST_TEST(children(tr) == (ints{1}), boost::test_tools::per_element());
+  BOOST_TEST(inorder(tr) == (ints{1, 3, 2, 5, 4, -2, -1}),
+             boost::test_tools::per_element());
+
+  // And back to top-level.
+  tr.move(tr.begin(), b2);
+  BOOST_TEST(inorder(tr) == (ints{2, 5, 4, -2, 1, 3, -1}),
+             boost::test_tools::per_element());
+}
+
+BOOST_AUTO_TEST_CASE(subtree_membership) {
+  tree tr;
+  branch b1{1}, b2{2};
+  leaf l1{3};
+  tr.insert(tr.end(), b1);
+  b1.insert(b1.end(), b2);
+  b2.insert(b2.end(), l1);
+
+  BOOST_TEST(l1.in_subtree_of(l1));
+  BOOST_TEST(l1.in_subtree_of(b2));
+  BOOST_TEST(l1.in_subtree_of(b1));
+  BOOST_TEST(!b1.in_subtree_of(b2));
+  BOOST_TEST(!b2.in_subtree_of(l1));
+
+  leaf orphan{4};
+  BOOST_TEST(!orphan.in_subtree_of(b1));
+}
+
+BOOST_AUTO_TEST_SUITE_END() // splice
+
+BOOST_AUTO_TEST_SUITE_END() // semitree
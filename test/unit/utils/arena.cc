@@ -0,0 +1,88 @@
+//------------------------------------------------------------------------------
+//
+// Basic tests for monotonic arena.
+//
+//------------------------------------------------------------------------------
+//
+// This file is licensed after LGPL v3
+// Look at: https://www.gnu.org/licenses/lgpl-3.0.en.html for details
+//
+//------------------------------------------------------------------------------
+
+#include "utils/arena.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+struct point_t {
+  int x, y;
+  point_t(int a, int b) : x(a), y(b) {}
+};
+
+bool aligned(const void *p, std::size_t align) {
+  return reinterpret_cast<std::uintptr_t>(p) % align == 0;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(utils_tests)
+
+BOOST_AUTO_TEST_SUITE(arena)
+
+BOOST_AUTO_TEST_CASE(create_objects) {
+  utils::arena_t a;
+  auto *p = a.create<point_t>(1, 2);
+  auto *c = a.create<char>('c');
+  auto *d = a.create<double>(3.5);
+  BOOST_TEST(p->x == 1);
+  BOOST_TEST(p->y == 2);
+  BOOST_TEST(*c == 'c');
+  BOOST_TEST(*d == 3.5);
+  BOOST_TEST(aligned(p, alignof(point_t)));
+  BOOST_TEST(aligned(d, alignof(double)));
+  BOOST_TEST(a.nchunks() == 1);
+}
+
+BOOST_AUTO_TEST_CASE(arrays_and_copies) {
+  utils::arena_t a;
+  auto *zeros = a.create_array<int>(10);
+  for (int i = 0; i != 10; ++i)
+    BOOST_TEST(zeros[i] == 0);
+  BOOST_TEST(a.create_array<int>(0) == nullptr);
+
+  std::vector<int> v{1, 2, 3, 4};
+  int *cp = a.copy(v.data(), v.size());
+  v.assign(4, 0);
+  BOOST_TEST(cp[0] == 1);
+  BOOST_TEST(cp[3] == 4);
+  BOOST_TEST(a.copy(v.data(), 0) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(chunks_and_release) {
+  utils::arena_t a{64};
+  std::vector<int *> ps;
+  for (int i = 0; i != 100; ++i)
+    ps.push_back(a.create<int>(i));
+  for (int i = 0; i != 100; ++i)
+    BOOST_TEST(*ps[i] == i);
+  BOOST_TEST(a.nchunks() > 1);
+  BOOST_TEST(a.used() >= 100 * sizeof(int));
+
+  // request bigger than chunk gets its own
+  auto *big = a.create_array<char>(1000);
+  big[999] = 'x';
+  BOOST_TEST(big[999] == 'x');
+
+  a.release();
+  BOOST_TEST(a.nchunks() == 0);
+  BOOST_TEST(a.used() == 0);
+  BOOST_TEST(*a.create<int>(42) == 42);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -16,8 +16,11 @@
 #include <boost/iostreams/stream.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
+#include <random>
 #include <sstream>
 #include <string>
+#include <vector>
 
 auto make_null_stream() {
   return boost::iostreams::stream{boost::iostreams::null_sink{}};
@@ -121,6 +124,87 @@ BOOST_AUTO_TEST_CASE(stream) {
   BOOST_TEST(oss.str() == "Hello\n  World\n!");
 }
 
+// Same text split into blocks at every position, written as single chars
+// and indented deeper than one run of spaces, gives same output.
+BOOST_AUTO_TEST_CASE(block_boundaries) {
+  using namespace utils;
+
+  std::string in{"Hello\n\nWorld\n!\n"};
+  std::string out{"Hello\n\n" + std::string(40, ' ') + "World\n" +
+                  std::string(40, ' ') + "!\n"};
+
+  // first line is written before indentation increases
+  for (std::size_t split = 6; split <= in.size(); ++split) {
+    std::ostringstream oss;
+    indent_ostream_t ios{oss, 20};
+    ios << "Hello\n" << increase_indent << increase_indent;
+    ios.write(in.data() + 6, split - 6);
+    ios.write(in.data() + split, in.size() - split);
+    BOOST_TEST(oss.str() == out);
+  }
+
+  std::ostringstream oss;
+  indent_ostream_t ios{oss, 20};
+  ios << increase_indent << increase_indent;
+  for (char c : in)
+    ios.put(c);
+  BOOST_TEST(oss.str() == out);
+}
+
+// Random text with empty lines and indentation changes between pieces gives
+// same output when pieces are written char by char, in random blocks and
+// whole at once.
+BOOST_AUTO_TEST_CASE(multichar_matches_single) {
+  using namespace utils;
+
+  std::mt19937 gen{42};
+  std::vector<std::string> pieces;
+  for (int i = 0; i < 200; ++i) {
+    std::string s;
+    int nlines = gen() % 4;
+    for (int l = 0; l < nlines; ++l) {
+      s.append(gen() % 4 == 0 ? 0 : 1 + gen() % 30, 'a' + gen() % 26);
+      s.push_back('\n');
+    }
+    s.append(gen() % 10, 'x');
+    pieces.push_back(s);
+  }
+
+  // levels go up to 3 and back, every piece has its own level
+  auto run = [&pieces](auto write) {
+    std::ostringstream oss;
+    indent_ostream_t ios{oss, 2};
+    for (std::size_t i = 0; i < pieces.size(); ++i) {
+      if (i % 8 < 3)
+        ios << increase_indent;
+      else if (i % 8 < 6)
+        ios << decrease_indent;
+      write(ios, pieces[i]);
+    }
+    ios.flush();
+    return oss.str();
+  };
+
+  auto bychar = run([](std::ostream &os, const std::string &s) {
+    for (char c : s)
+      os.put(c);
+  });
+  auto byblock = run([&gen](std::ostream &os, const std::string &s) {
+    for (std::size_t i = 0; i < s.size();) {
+      std::size_t n = std::min<std::size_t>(1 + gen() % 7, s.size() - i);
+      os.write(s.data() + i, n);
+      i += n;
+    }
+  });
+  auto whole = run([](std::ostream &os, const std::string &s) {
+    os.write(s.data(), s.size());
+  });
+
+  BOOST_TEST(bychar.find("\n      ") != std::string::npos);
+  BOOST_TEST(bychar == byblock);
+  BOOST_TEST(bychar == whole);
+}
+
 BOOST_AUTO_TEST_CASE(ignored_manip) {
   using namespace utils;
 
@@ -8,6 +8,8 @@
 // (3) locIR from controlgraph                   (--pg-locs)
 // (4) exprIR from locIR                         (--pg-arith)
 //
+// every exprIR is then printed by langprinter to program.<indexes>.c
+//
 // Main sequence is putting tasks on queue and getting required futures
 //
 // High level order is:
@@ -64,6 +66,8 @@ void coerunner_t::run(int argc, char **argv) {
 
   nvar_ = cfg::get(*default_config_, PG::VAR);
   nsplits_ = cfg::get(*default_config_, PG::SPLITS);
+  nlocs_ = cfg::get(*default_config_, PG::LOCS);
+  narith_ = cfg::get(*default_config_, PG::ARITH);
 
   run_typegraph();
 
@@ -125,10 +129,20 @@ void coerunner_t::run_varassign(va_task_req_state_t s) {
   std::vector<varassign_future_t> future_assigns;
   future_assigns.reserve(nvar_);
 
+  // globals layer built once and shared by all randomizations
+  globals_sp_t globals;
+  if (cfg::get(*default_config_, VA::SHAREGLOBALS)) {
+    int vgseed = default_config_->rand_positive();
+    auto &&[globals_task, globals_fut] =
+        create_task(globals_create, vgseed, *default_config_, s.tg);
+    push_task(std::move(globals_task));
+    globals = globals_fut.get();
+  }
+
   for (int i = 0; i < nvar_; ++i) {
     int vaseed = default_config_->rand_positive();
-    auto &&[vassign_task, vassign_fut] =
-        create_task(varassign_create, vaseed, *default_config_, s.tg, s.cg);
+    auto &&[vassign_task, vassign_fut] = create_task(
+        varassign_create, vaseed, *default_config_, s.tg, s.cg, globals);
 
     future_assigns.emplace_back(std::move(vassign_fut));
     push_task(std::move(vassign_task));
@@ -179,11 +193,68 @@ void coerunner_t::run_controlgraph(cn_task_req_state_t s) {
 }
 
 void coerunner_t::run_locir(li_task_req_state_t s) {
-  // TODO: put locir tasks
-  ei_task_req_state_t sub{s};
-  run_exprir(sub);
+  std::vector<locir_future_t> future_locirs;
+  future_locirs.reserve(nlocs_);
+
+  for (int i = 0; i < nlocs_; ++i) {
+    int liseed = default_config_->rand_positive();
+    auto &&[li_task, li_fut] =
+        create_task(locir_create, liseed, *default_config_, s.tg, s.va, s.cn);
+    future_locirs.emplace_back(std::move(li_fut));
+    push_task(std::move(li_task));
+  }
+
+  auto stop_after_li = cfg::get(*default_config_, PGC::STOP_ON_LI);
+
+  for (int i = 0; i < nlocs_; ++i) {
+    ei_task_req_state_t sub{s, future_locirs[i].get(), i};
+    if (default_config_->dumps()) {
+      std::ostringstream os;
+      os << "locir." << s.nva << "." << s.nc << "." << i;
+      std::ofstream of(os.str());
+      locir_dump(sub.li, of);
+    }
+
+    if (!stop_after_li)
+      run_exprir(sub);
+  }
 }
 
-void coerunner_t::run_exprir(ei_task_req_state_t) {
-  // TODO: put exprir tasks
+void coerunner_t::run_exprir(ei_task_req_state_t s) {
+  std::vector<exprir_future_t> future_exprirs;
+  future_exprirs.reserve(narith_);
+
+  for (int i = 0; i < narith_; ++i) {
+    int eiseed = default_config_->rand_positive();
+    auto &&[ei_task, ei_fut] =
+        create_task(exprir_create, eiseed, *default_config_, s.tg, s.cg, s.li);
+    future_exprirs.emplace_back(std::move(ei_fut));
+    push_task(std::move(ei_task));
+  }
+
+  auto stop_after_ei = cfg::get(*default_config_, PGC::STOP_ON_EI);
+  std::vector<printer_future_t> future_printers;
+  future_printers.reserve(narith_);
+
+  for (int i = 0; i < narith_; ++i) {
+    auto ei = future_exprirs[i].get();
+    std::ostringstream os;
+    os << s.nva << "." << s.nc << "." << s.nl << "." << i;
+    if (default_config_->dumps()) {
+      std::ofstream of("exprir." + os.str());
+      exprir_dump(ei, of);
+    }
+
+    if (stop_after_ei)
+      continue;
+
+    auto fname = "program." + os.str() + ".c";
+    auto &&[lp_task, lp_fut] =
+        create_task(langprinter_print, s.tg, s.cg, s.va, ei, fname);
+    future_printers.emplace_back(std::move(lp_fut));
+    push_task(std::move(lp_task));
+  }
+
+  for (auto &fut : future_printers)
+    fut.get();
 }
@@ -30,6 +30,24 @@ void push_sentinel_task() {
   push_task(std::move(sentinel));
 }
 
+// sentinel is not ours to consume: put it back for consumers
+bool run_pending_task() {
+  task_t cur;
+  {
+    std::lock_guard<std::mutex> lk{task_queue_mutex};
+    if (task_queue.empty())
+      return false;
+    cur = std::move(task_queue.front());
+    task_queue.pop();
+  }
+
+  if (std::move(cur)() == -1) {
+    push_sentinel_task();
+    return false;
+  }
+  return true;
+}
+
 //------------------------------------------------------------------------------
 //
 // consumer_thread_func -- entry point for queue consumer thread